@@ -0,0 +1,45 @@
+/*
+ * Timing for the host benchmarks. A case gets one untimed warm-up pass
+ * of ops calls and then BENCH_REPS timed passes; ns/op comes from the
+ * fastest pass, the mean is reported next to it. Every case prints one
+ * JSON object per line, so runs can be collected and compared.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BENCH_REPS 9
+
+static volatile int32_t bench_out; // rezultatite odat tuka, da ne gi frli kompajlerot
+
+static inline uint64_t bench_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, & ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline double bench_case(const char * group, const char * name, void (* fn)(int i), int ops) {
+  uint64_t best = UINT64_MAX, sum = 0;
+
+  for (int i = 0; i < ops; i++)
+    fn(i);
+  for (int r = 0; r < BENCH_REPS; r++) {
+    uint64_t t0 = bench_ns();
+    for (int i = 0; i < ops; i++)
+      fn(i);
+    uint64_t d = bench_ns() - t0;
+    sum += d;
+    if (d < best)
+      best = d;
+  }
+
+  double ns_op = (double) best / ops;
+  printf("{\"bench\":\"%s\",\"case\":\"%s\",\"ops\":%d,\"reps\":%d,\"ns_op\":%.2f,\"ns_op_mean\":%.2f,\"ops_s\":%.0f}\n",
+         group, name, ops, BENCH_REPS, ns_op, (double) sum / BENCH_REPS / ops, ns_op > 0 ? 1e9 / ns_op : 0.0);
+  return ns_op;
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Cost per log statement: LOG() at the call site, LOG() together with
+ * the log_flush() that frames it onto the UART3 ring, and the
+ * snprintf() into the same ring that the printf() calls did before
+ * the deferred log. The statements are the ones that were converted.
+ * The ring is emptied after every statement, as if the UART had sent
+ * it, so no case runs into a full buffer.
+ */
+#include "fw.h"
+#include "bench.h"
+
+#define OPS 100000
+
+static char text[96];
+
+static const char * scope_names[] = {"sensors", "normalize", "draw", "flush", "leds", "eeprom"};
+
+// UART-ot go isprakja se pred sledniot iskaz
+static void sent(void) {
+  tlm_tail = tlm_head;
+  log_tail = log_head;
+}
+
+static void print(int len) {
+  tlm_queue((uint8_t * ) text, len < (int) sizeof(text) ? len : sizeof(text) - 1);
+  sent();
+}
+
+static void log_ch7seg(int i) {
+  LOG(LOG_CH7SEG, i & 7);
+  sent();
+}
+
+static void log_flush_ch7seg(int i) {
+  LOG(LOG_CH7SEG, i & 7);
+  log_flush();
+  sent();
+}
+
+static void printf_ch7seg(int i) {
+  print(snprintf(text, sizeof(text), "ch7seg++: %d\n", i & 7));
+}
+
+static void log_record(int i) {
+  LOG(LOG_RECORD_DONE, REC_COUNT, i & 31);
+  sent();
+}
+
+static void log_flush_record(int i) {
+  LOG(LOG_RECORD_DONE, REC_COUNT, i & 31);
+  log_flush();
+  sent();
+}
+
+static void printf_record(int i) {
+  print(snprintf(text, sizeof(text), "recorded %d records, %d page writes\n", REC_COUNT, i & 31));
+}
+
+static void log_prof(int i) {
+  LOG(LOG_PROF_STAT, i % PRF_COUNT, i, 120, 300 + (i & 255), 4000 + i);
+  sent();
+}
+
+static void log_flush_prof(int i) {
+  LOG(LOG_PROF_STAT, i % PRF_COUNT, i, 120, 300 + (i & 255), 4000 + i);
+  log_flush();
+  sent();
+}
+
+static void printf_prof(int i) {
+  print(snprintf(text, sizeof(text), "%s %u %u %u %u\n", scope_names[i % PRF_COUNT], i, 120,
+                 300 + (i & 255), 4000 + i));
+}
+
+static void statement(const char * name, void (* log)(int i), void (* flushed)(int i), void (* printed)(int i)) {
+  char case_name[64];
+
+  snprintf(case_name, sizeof(case_name), "log_%s", name);
+  double l = bench_case("log", case_name, log, OPS);
+  snprintf(case_name, sizeof(case_name), "log_flush_%s", name);
+  double f = bench_case("log", case_name, flushed, OPS);
+  snprintf(case_name, sizeof(case_name), "printf_%s", name);
+  double p = bench_case("log", case_name, printed, OPS);
+  printf("{\"bench\":\"log\",\"statement\":\"%s\",\"ns_log\":%.2f,\"ns_log_flush\":%.2f,\"ns_printf\":%.2f}\n",
+         name, l, f, p);
+}
+
+int main(void) {
+  fw_boot();
+
+  statement("ch7seg", log_ch7seg, log_flush_ch7seg, printf_ch7seg);
+  statement("record_done", log_record, log_flush_record, printf_record);
+  statement("prof_stat", log_prof, log_flush_prof, printf_prof);
+  if (log_stats.dropped || tlm_stats.dropped) {
+    fprintf(stderr, "bench_log: %u log entries, %u packets dropped\n", log_stats.dropped, tlm_stats.dropped);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Sampling loop benchmark: read_sensors(), normalization into the
+ * history windows, zapisi() and draw_graph_real_time(), one recording
+ * session of REC_COUNT samples after another.
+ *
+ * Host time per sample is what the firmware code costs on this machine
+ * (the simulator's own work in blocking drivers included), virtual time
+ * is what the same sample takes on the board's clock.
+ */
+#include <time.h>
+
+#include "fw.h"
+
+#define SAMPLES 4000
+
+enum { ST_READ, ST_NORM, ST_STORE, ST_DRAW, ST_COUNT };
+
+static const char * const stage_names[ST_COUNT] = {"read_sensors", "normalize", "zapisi", "draw_graph"};
+
+static uint64_t host_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, & ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int main(void) {
+  uint64_t ns[ST_COUNT] = {0};
+  uint64_t us[ST_COUNT] = {0};
+  int32_t v[CH_COUNT];
+  int sessions = 0;
+
+  fw_boot();
+  active_window = & history[CH_TEMPERATURE];
+
+  for (int i = 0; i < SAMPLES; i++) {
+    uint64_t t, vt;
+
+    if (i % REC_COUNT == 0) {
+      rec_n = 0;
+      store_begin(0);
+    }
+    sim.pot = (uint16_t) (i * 37 & 0xfff);
+    sim.lux = 50 + i % 900;
+    sim.temp = 200 + i % 100;
+
+    t = host_ns();
+    vt = sim_now();
+    read_sensors(v);
+    ns[ST_READ] += host_ns() - t;
+    us[ST_READ] += sim_now() - vt;
+
+    t = host_ns();
+    vt = sim_now();
+#define BENCH_PUSH(ch, name, rd, norm, bits, bias, led) window_push( & history[ch], norm(v[ch]));
+    SENSORS(BENCH_PUSH)
+    ns[ST_NORM] += host_ns() - t;
+    us[ST_NORM] += sim_now() - vt;
+
+    t = host_ns();
+    vt = sim_now();
+    zapisi(v);
+    rec_n++;
+    ns[ST_STORE] += host_ns() - t;
+    us[ST_STORE] += sim_now() - vt;
+
+    t = host_ns();
+    vt = sim_now();
+    draw_graph_real_time(active_window, channel_names[CH_TEMPERATURE]);
+    ns[ST_DRAW] += host_ns() - t;
+    us[ST_DRAW] += sim_now() - vt;
+
+    if (rec_n == REC_COUNT) {
+      store_commit();
+      sessions++;
+    }
+  }
+  i2c_sync();
+  oled_wait();
+
+  printf("bench_loop: %d samples, %d sessions\n", SAMPLES, sessions);
+  printf("%-14s %12s %14s\n", "stage", "ns/sample", "virt us/sample");
+  for (int s = 0; s < ST_COUNT; s++)
+    printf("%-14s %12.0f %14.1f\n", stage_names[s], (double) ns[s] / SAMPLES, (double) us[s] / SAMPLES);
+  printf("%-14s %12.0f %14.1f\n", "total",
+         (double) (ns[0] + ns[1] + ns[2] + ns[3]) / SAMPLES,
+         (double) (us[0] + us[1] + us[2] + us[3]) / SAMPLES);
+  printf("i2c %u jobs %.1f%% busy, eeprom %u page writes, oled %u bytes, %u ISR storms\n",
+         sim.i2c.jobs, 100.0 * sim.i2c.busy_us / sim_now(), sim.eeprom.page_writes, sim.oled.bytes,
+         sim.core.storms);
+  return 0;
+}
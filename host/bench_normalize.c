@@ -0,0 +1,43 @@
+/*
+ * Fixed-point normalize_* kernels against the double versions they replaced.
+ * On the host both are cheap; the soft-float gap on the Cortex-M3 is
+ * larger, but the ratio shows which way it goes.
+ */
+#include "fw.h"
+#include "bench.h"
+
+#define OPS 100000
+
+static int32_t in_temp(int i) { return 150 + i % 250; }
+static int32_t in_light(int i) { return i % 4000; }
+static int32_t in_pot(int i) { return i & 0xfff; }
+
+static void q_temp(int i) { bench_out = normalize_temperature(in_temp(i)); }
+static void q_light(int i) { bench_out = normalize_light(in_light(i)); }
+static void q_pot(int i) { bench_out = normalize_potentiometer(in_pot(i)); }
+
+static void d_temp(int i) {
+  volatile double v = (double) in_temp(i);
+  v = v / 10;
+  bench_out = (int32_t) ((((v - 15) / 20) * 43) + 10);
+}
+
+static void d_light(int i) {
+  volatile double v = (double) in_light(i);
+  bench_out = (int32_t) (((v / 4000) * 43) + 10);
+}
+
+static void d_pot(int i) {
+  volatile double v = (double) in_pot(i);
+  bench_out = (int32_t) (((v / 4095) * 43) + 10);
+}
+
+int main(void) {
+  bench_case("normalize", "fixed_temperature", q_temp, OPS);
+  bench_case("normalize", "double_temperature", d_temp, OPS);
+  bench_case("normalize", "fixed_light", q_light, OPS);
+  bench_case("normalize", "double_light", d_light, OPS);
+  bench_case("normalize", "fixed_potentiometer", q_pot, OPS);
+  bench_case("normalize", "double_potentiometer", d_pot, OPS);
+  return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * The pipeline stages one by one over pseudo-random inputs, as the
+ * start-up benchmark on the board used to run them: the normalize_*
+ * calls, the LED bar lookup, record encode and decode, one graph frame,
+ * and procitaj() parsing a full session back out of the EEPROM.
+ */
+#include "fw.h"
+#include "bench.h"
+
+#define OPS 100000
+#define DRAW_OPS 2000
+#define READ_OPS 100
+
+static uint32_t seed = 1;
+static uint8_t recs[256][REC_SIZE];
+static sample_window_t window;
+
+static uint32_t rnd(void) {
+  seed = seed * 1664525 + 1013904223;
+  return seed >> 8;
+}
+
+static void random_record(int32_t * v) {
+  v[CH_TEMPERATURE] = 150 + rnd() % 250;
+  v[CH_LIGHT] = rnd() % 4000;
+  v[CH_POTENTIOMETER] = rnd() & 0xfff;
+  v[CH_ACCELERATION] = (int8_t) rnd();
+}
+
+static void norm_temp(int i) {
+  bench_out = normalize_temperature(150 + rnd() % 250);
+}
+
+static void norm_light(int i) {
+  bench_out = normalize_light(rnd() % 4000);
+}
+
+static void norm_pot(int i) {
+  bench_out = normalize_potentiometer(rnd() & 0xfff);
+}
+
+static void led_map(int i) {
+  bench_out = led_bar[led_level(rnd() % 60)];
+}
+
+static void encode(int i) {
+  int32_t v[CH_COUNT];
+
+  random_record(v);
+  record_encode(recs[i & 255], v);
+}
+
+static void decode(int i) {
+  int32_t v[CH_COUNT];
+
+  bench_out = record_decode(recs[i & 255], v) + v[i % CH_COUNT];
+}
+
+static void draw(int i) {
+  window_push( & window, 10 + rnd() % 43);
+  draw_graph_real_time( & window, "Bench");
+}
+
+static void read_session(int i) {
+  bench_out = procitaj(i % CH_COUNT, 0);
+}
+
+int main(void) {
+  int32_t v[CH_COUNT];
+
+  fw_boot();
+  i2c_sync();
+
+  // edna cela sesija vo EEPROM za procitaj()
+  store_begin(0);
+  for (rec_n = 0; rec_n < REC_COUNT; rec_n++) {
+    random_record(v);
+    zapisi(v);
+  }
+  store_commit();
+  i2c_sync();
+  if (procitaj(CH_LIGHT, 0) != REC_COUNT) {
+    fprintf(stderr, "bench_pipeline: session did not read back\n");
+    return 1;
+  }
+
+  bench_case("pipeline", "normalize_temperature", norm_temp, OPS);
+  bench_case("pipeline", "normalize_light", norm_light, OPS);
+  bench_case("pipeline", "normalize_potentiometer", norm_pot, OPS);
+  bench_case("pipeline", "led_map", led_map, OPS);
+  bench_case("pipeline", "record_encode", encode, OPS);
+  bench_case("pipeline", "record_decode", decode, OPS);
+  bench_case("pipeline", "draw_graph_real_time", draw, DRAW_OPS);
+  oled_wait();
+  bench_case("pipeline", "procitaj", read_session, READ_OPS);
+  return 0;
+}
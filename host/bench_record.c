@@ -0,0 +1,66 @@
+/*
+ * Packed binary records against the 11-character ASCII format they
+ * replaced (sprintf("%03d%04d%04d") on the way in, substring copies
+ * and strtol() on the way out).
+ */
+#include <stdlib.h>
+
+#include "fw.h"
+#include "bench.h"
+
+#define OPS 100000
+
+static int32_t in[CH_COUNT];
+static uint8_t rec[REC_SIZE];
+static char text[16];
+
+static void fill(int i) {
+  in[CH_TEMPERATURE] = 200 + i % 100;
+  in[CH_LIGHT] = i % 4000;
+  in[CH_POTENTIOMETER] = i & 0xfff;
+  in[CH_ACCELERATION] = (i % 256) - 128;
+}
+
+static void binary_encode(int i) {
+  fill(i);
+  record_encode(rec, in);
+  bench_out = rec[1];
+}
+
+static void binary_decode(int i) {
+  int32_t v[CH_COUNT];
+  bench_out = record_decode(rec, v) + v[i % CH_COUNT];
+}
+
+static void ascii_encode(int i) {
+  fill(i);
+  sprintf(text, "%03d%04d%04d", (int) (in[CH_TEMPERATURE] % 1000), (int) in[CH_LIGHT],
+          (int) in[CH_POTENTIOMETER]);
+  bench_out = text[1];
+}
+
+static void ascii_decode(int i) {
+  char part[5];
+  int32_t v[3];
+
+  memcpy(part, text, 3);
+  part[3] = 0;
+  v[0] = strtol(part, NULL, 10);
+  memcpy(part, text + 3, 4);
+  part[4] = 0;
+  v[1] = strtol(part, NULL, 10);
+  memcpy(part, text + 7, 4);
+  v[2] = strtol(part, NULL, 10);
+  bench_out = v[i % 3];
+}
+
+int main(void) {
+  fill(0);
+  record_encode(rec, in);
+  bench_case("record", "binary_encode", binary_encode, OPS);
+  bench_case("record", "binary_decode", binary_decode, OPS);
+  bench_case("record", "ascii_encode", ascii_encode, OPS);
+  bench_case("record", "ascii_decode", ascii_decode, OPS);
+  printf("{\"bench\":\"record\",\"binary_bytes\":%d,\"ascii_bytes\":11}\n", REC_SIZE);
+  return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * The SENSORS() table expansions against the same work written out by
+ * hand for each channel, the way measure_temperature(), measure_light()
+ * and measure_potentiometer() did it: normalization into the history
+ * windows, normalize_channel() as procitaj() uses it, record encode and
+ * decode, and the LED bar. Each pair ends with a line giving the table
+ * time as a ratio of the hand-written one.
+ */
+#include "fw.h"
+#include "bench.h"
+
+#define OPS 100000
+
+static uint32_t seed = 1;
+static int32_t raw[256][CH_COUNT];
+static uint8_t recs[256][REC_SIZE];
+
+static void random_raw(int32_t * v) {
+  seed = seed * 1664525 + 1013904223;
+  v[CH_TEMPERATURE] = 150 + (seed >> 8) % 250;
+  v[CH_LIGHT] = (seed >> 4) % 4000;
+  v[CH_POTENTIOMETER] = seed >> 20;
+  v[CH_ACCELERATION] = (int8_t) (seed >> 12);
+}
+
+static void table_push(int i) {
+  int32_t * v = raw[i & 255];
+#define BENCH_PUSH(ch, name, rd, norm, bits, bias, led) window_push( & history[ch], norm(v[ch]));
+  SENSORS(BENCH_PUSH)
+}
+
+static void hand_push(int i) {
+  int32_t * v = raw[i & 255];
+  window_push( & history[CH_TEMPERATURE], normalize_temperature(v[CH_TEMPERATURE]));
+  window_push( & history[CH_LIGHT], normalize_light(v[CH_LIGHT]));
+  window_push( & history[CH_POTENTIOMETER], normalize_potentiometer(v[CH_POTENTIOMETER]));
+  window_push( & history[CH_ACCELERATION], normalize_acceleration(v[CH_ACCELERATION]));
+}
+
+static void table_norm(int i) {
+  bench_out = normalize_channel(i % CH_COUNT, raw[i & 255][i % CH_COUNT]);
+}
+
+static void hand_norm(int i) {
+  int ch = i % CH_COUNT;
+  int32_t v = raw[i & 255][ch];
+
+  if (ch == CH_TEMPERATURE)
+    bench_out = normalize_temperature(v);
+  else if (ch == CH_LIGHT)
+    bench_out = normalize_light(v);
+  else if (ch == CH_POTENTIOMETER)
+    bench_out = normalize_potentiometer(v);
+  else
+    bench_out = normalize_acceleration(v);
+}
+
+static void table_encode(int i) {
+  record_encode(recs[i & 255], raw[i & 255]);
+}
+
+// istiot format, poleto po pole
+static void hand_encode(int i) {
+  const int32_t * v = raw[i & 255];
+  rec_bits_t r = { recs[i & 255], 0, 0 };
+
+  rec_put( & r, REC_VERSION, 4);
+  rec_put( & r, v[CH_TEMPERATURE] + REC_TEMP_OFFSET, 12);
+  rec_put( & r, v[CH_LIGHT], 12);
+  rec_put( & r, v[CH_POTENTIOMETER], 12);
+  rec_put( & r, v[CH_ACCELERATION] + 128, 8);
+}
+
+static void table_decode(int i) {
+  int32_t v[CH_COUNT];
+
+  bench_out = record_decode(recs[i & 255], v) + v[i % CH_COUNT];
+}
+
+static void hand_decode(int i) {
+  int32_t v[CH_COUNT];
+  rec_bits_t r = { recs[i & 255], 0, 0 };
+
+  if (rec_get( & r, 4) != REC_VERSION)
+    return;
+  v[CH_TEMPERATURE] = rec_get( & r, 12) - REC_TEMP_OFFSET;
+  v[CH_LIGHT] = rec_get( & r, 12);
+  v[CH_POTENTIOMETER] = rec_get( & r, 12);
+  v[CH_ACCELERATION] = rec_get( & r, 8) - 128;
+  bench_out = 1 + v[i % CH_COUNT];
+}
+
+// LED lentata bez I2C, samo maskata
+static void table_leds(int i) {
+  int ch = i & 1 ? CH_LIGHT : CH_TEMPERATURE;
+  int32_t v = normalize_channel(ch, raw[i & 255][ch]);
+
+  switch (ch) {
+#define BENCH_LED(c, name, rd, norm, bits, bias, led) \
+  case c: \
+    if ((led) != LED_NONE) \
+      bench_out = led_bar[led_level(v)] << ((led) & 15); \
+    break;
+    SENSORS(BENCH_LED)
+  }
+}
+
+static void hand_leds(int i) {
+  if (i & 1)
+    bench_out = led_bar[led_level(normalize_light(raw[i & 255][CH_LIGHT]))] << 8;
+  else
+    bench_out = led_bar[led_level(normalize_temperature(raw[i & 255][CH_TEMPERATURE]))];
+}
+
+static void pair(const char * name, void (* table)(int i), void (* hand)(int i)) {
+  char table_name[64], hand_name[64];
+
+  snprintf(table_name, sizeof(table_name), "table_%s", name);
+  snprintf(hand_name, sizeof(hand_name), "hand_%s", name);
+  double t = bench_case("sensors", table_name, table, OPS);
+  double h = bench_case("sensors", hand_name, hand, OPS);
+  printf("{\"bench\":\"sensors\",\"pair\":\"%s\",\"table_vs_hand\":%.2f}\n", name, h > 0 ? t / h : 0.0);
+}
+
+int main(void) {
+  for (int i = 0; i < 256; i++) {
+    random_raw(raw[i]);
+    record_encode(recs[i], raw[i]);
+  }
+  // rakata mora da go dava istiot zapis
+  uint8_t table[REC_SIZE];
+  memcpy(table, recs[7], REC_SIZE);
+  hand_encode(7);
+  if (memcmp(table, recs[7], REC_SIZE) != 0) {
+    fprintf(stderr, "bench_sensors: hand_encode differs from record_encode\n");
+    return 1;
+  }
+
+  pair("push", table_push, hand_push);
+  pair("normalize_channel", table_norm, hand_norm);
+  pair("encode", table_encode, hand_encode);
+  pair("decode", table_decode, hand_decode);
+  pair("leds", table_leds, hand_leds);
+  return 0;
+}
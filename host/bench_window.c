@@ -0,0 +1,47 @@
+/*
+ * Circular sample window against the shift-by-one arrays it replaced:
+ * one push per sample and one oldest-to-newest read of the whole window
+ * per redraw.
+ */
+#include "fw.h"
+#include "bench.h"
+
+#define OPS 100000
+
+static sample_window_t ring;
+static int32_t shifted[WINDOW_DEPTH];
+
+static void ring_push(int i) {
+  window_push( & ring, i);
+}
+
+// kako prethodno vo measure_*: site elementi edno mesto nalevo
+static void shift_push(int i) {
+  for (int k = 0; k < WINDOW_DEPTH - 1; k++)
+    shifted[k] = shifted[k + 1];
+  shifted[WINDOW_DEPTH - 1] = i;
+}
+
+static void ring_read(int i) {
+  int32_t s = 0;
+  for (int k = 0; k < ring.count; k++)
+    s += window_get( & ring, k);
+  bench_out = s + i;
+}
+
+static void shift_read(int i) {
+  int32_t s = 0;
+  for (int k = 0; k < WINDOW_DEPTH; k++)
+    s += shifted[k];
+  bench_out = s + i;
+}
+
+int main(void) {
+  window_clear( & ring);
+  bench_case("window", "ring_push", ring_push, OPS);
+  bench_case("window", "shift_push", shift_push, OPS);
+  bench_case("window", "ring_read", ring_read, OPS);
+  bench_case("window", "shift_read", shift_read, OPS);
+  bench_out = shifted[0] + ring.values[0];
+  return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Minimal assertions for the host tests. A failed CHECK prints the
+ * condition and keeps going, check_done() gives the exit status.
+ */
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int check_failed;
+
+#define CHECK(c) \
+  do { \
+    if (!(c)) { \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); \
+      check_failed++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    long long a_ = (long long) (a), b_ = (long long) (b); \
+    if (a_ != b_) { \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, a_, b_); \
+      check_failed++; \
+    } \
+  } while (0)
+
+#define CHECK_RANGE(v, lo, hi) \
+  do { \
+    long long v_ = (long long) (v); \
+    if (v_ < (long long) (lo) || v_ > (long long) (hi)) { \
+      printf("%s:%d: CHECK_RANGE(%s) failed: %lld not in [%lld, %lld]\n", __FILE__, __LINE__, #v, v_, \
+             (long long) (lo), (long long) (hi)); \
+      check_failed++; \
+    } \
+  } while (0)
+
+static inline int check_done(const char * name) {
+  printf("%s: %s\n", name, check_failed ? "FAIL" : "ok");
+  return check_failed ? 1 : 0;
+}
+
+#endif
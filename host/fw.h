@@ -0,0 +1,62 @@
+/*
+ * The firmware as a host library. main.c is compiled into each test
+ * and benchmark, so they reach its static state and functions directly;
+ * its main() becomes fw_main() and is not used.
+ *
+ * Firmware globals start from zero once per process. A test that needs
+ * a power cycle runs the first boot in a child with fw_fork(), the
+ * EEPROM is shared with the child and survives it.
+ */
+#ifndef FW_H
+#define FW_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define main fw_main
+#include "../src/main.c"
+#undef main
+
+static inline void fw_boot(void) {
+  sim_reset();
+  init_app();
+}
+
+// glavnata jamka na firmware-ot do dadeno virtuelno vreme
+static inline void fw_run_until(uint64_t us) {
+  while (sim_now() < us) {
+    sched_run();
+    sched_idle();
+  }
+}
+
+static inline void fw_run(uint32_t ms) {
+  fw_run_until(sim_now() + (uint64_t) ms * 1000);
+}
+
+// SW3 na P0.4, SW4 na P1.31, so malku odbivanje na kontaktot
+static inline void fw_press(int sw, uint32_t hold_ms) {
+  if (sw == 3)
+    sim_button(0, 4, sim_now() + 1000, hold_ms * 1000, 3);
+  else
+    sim_button(1, 31, sim_now() + 1000, hold_ms * 1000, 3);
+}
+
+// vrakja izleznata sostojba na deteto, 0 i koga strujata e isklucena
+static inline int fw_fork(void (* child)(void)) {
+  int st;
+  fflush(stdout); // baferot inaku go pecati i deteto
+  pid_t pid = fork();
+  if (pid == 0) {
+    child();
+    _exit(0);
+  }
+  waitpid(pid, & st, 0);
+  return WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+}
+
+#endif
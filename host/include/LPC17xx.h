@@ -0,0 +1,207 @@
+/*
+ * Host stand-in for the CMSIS LPC17xx device header. The peripheral
+ * register blocks are plain memory owned by the simulator (sim/), and
+ * the core functions that are inline assembly on target are provided
+ * by sim/core.c. Only what the firmware and the simulated drivers use
+ * is declared here.
+ */
+#ifndef __LPC17xx_H__
+#define __LPC17xx_H__
+
+#include <stdint.h>
+
+typedef enum IRQn {
+  SysTick_IRQn = -1,
+  WDT_IRQn = 0,
+  TIMER0_IRQn = 1,
+  TIMER1_IRQn = 2,
+  TIMER2_IRQn = 3,
+  TIMER3_IRQn = 4,
+  UART0_IRQn = 5,
+  UART1_IRQn = 6,
+  UART2_IRQn = 7,
+  UART3_IRQn = 8,
+  PWM1_IRQn = 9,
+  I2C0_IRQn = 10,
+  I2C1_IRQn = 11,
+  I2C2_IRQn = 12,
+  SPI_IRQn = 13,
+  SSP0_IRQn = 14,
+  SSP1_IRQn = 15,
+  PLL0_IRQn = 16,
+  RTC_IRQn = 17,
+  EINT0_IRQn = 18,
+  EINT1_IRQn = 19,
+  EINT2_IRQn = 20,
+  EINT3_IRQn = 21,
+  ADC_IRQn = 22,
+  BOD_IRQn = 23,
+  USB_IRQn = 24,
+  CAN_IRQn = 25,
+  DMA_IRQn = 26
+} IRQn_Type;
+
+typedef struct {
+  volatile uint32_t IR;
+  volatile uint32_t TCR;
+  volatile uint32_t TC;
+  volatile uint32_t PR;
+  volatile uint32_t PC;
+  volatile uint32_t MCR;
+  volatile uint32_t MR0;
+  volatile uint32_t MR1;
+  volatile uint32_t MR2;
+  volatile uint32_t MR3;
+  volatile uint32_t CCR;
+  volatile uint32_t CR0;
+  volatile uint32_t CR1;
+  uint32_t RESERVED0[2];
+  volatile uint32_t EMR;
+  uint32_t RESERVED1[12];
+  volatile uint32_t CTCR;
+} LPC_TIM_TypeDef;
+
+typedef struct {
+  volatile uint32_t ADCR;
+  volatile uint32_t ADGDR;
+  uint32_t RESERVED0;
+  volatile uint32_t ADINTEN;
+  volatile uint32_t ADDR0;
+  volatile uint32_t ADDR1;
+  volatile uint32_t ADDR2;
+  volatile uint32_t ADDR3;
+  volatile uint32_t ADDR4;
+  volatile uint32_t ADDR5;
+  volatile uint32_t ADDR6;
+  volatile uint32_t ADDR7;
+  volatile uint32_t ADSTAT;
+  volatile uint32_t ADTRM;
+} LPC_ADC_TypeDef;
+
+typedef struct {
+  volatile uint32_t CR0;
+  volatile uint32_t CR1;
+  volatile uint32_t DR;
+  volatile uint32_t SR;
+  volatile uint32_t CPSR;
+  volatile uint32_t IMSC;
+  volatile uint32_t RIS;
+  volatile uint32_t MIS;
+  volatile uint32_t ICR;
+  volatile uint32_t DMACR;
+} LPC_SSP_TypeDef;
+
+typedef struct {
+  volatile uint32_t I2CONSET;
+  volatile uint32_t I2STAT;
+  volatile uint32_t I2DAT;
+  volatile uint32_t I2ADR0;
+  volatile uint32_t I2SCLH;
+  volatile uint32_t I2SCLL;
+  volatile uint32_t I2CONCLR;
+} LPC_I2C_TypeDef;
+
+typedef struct {
+  volatile uint32_t RBR_THR_DLL;
+  volatile uint32_t IER_DLM;
+  volatile uint32_t IIR_FCR;
+  volatile uint32_t LCR;
+  uint32_t RESERVED0;
+  volatile uint32_t LSR;
+  uint32_t RESERVED1;
+  volatile uint32_t SCR;
+  volatile uint32_t ACR;
+  volatile uint32_t ICR;
+  volatile uint32_t FDR;
+  uint32_t RESERVED2;
+  volatile uint32_t TER;
+} LPC_UART_TypeDef;
+
+// adresnite registri se so sirina na pokazuvac na host
+typedef struct {
+  volatile uintptr_t DMACCSrcAddr;
+  volatile uintptr_t DMACCDestAddr;
+  volatile uintptr_t DMACCLLI;
+  volatile uint32_t DMACCControl;
+  volatile uint32_t DMACCConfig;
+} LPC_GPDMACH_TypeDef;
+
+typedef struct {
+  volatile uint32_t DMACIntStat;
+  volatile uint32_t DMACIntTCStat;
+  volatile uint32_t DMACIntTCClear;
+  volatile uint32_t DMACIntErrStat;
+  volatile uint32_t DMACIntErrClr;
+  volatile uint32_t DMACRawIntTCStat;
+  volatile uint32_t DMACRawIntErrStat;
+  volatile uint32_t DMACEnbldChns;
+  volatile uint32_t DMACSoftBReq;
+  volatile uint32_t DMACSoftSReq;
+  volatile uint32_t DMACSoftLBReq;
+  volatile uint32_t DMACSoftLSReq;
+  volatile uint32_t DMACConfig;
+  volatile uint32_t DMACSync;
+} LPC_GPDMA_TypeDef;
+
+extern LPC_TIM_TypeDef sim_tim[4];
+extern LPC_ADC_TypeDef sim_adc;
+extern LPC_SSP_TypeDef sim_ssp1;
+extern LPC_I2C_TypeDef sim_i2c2;
+extern LPC_UART_TypeDef sim_uart3;
+extern LPC_GPDMA_TypeDef sim_gpdma;
+extern LPC_GPDMACH_TypeDef sim_gpdmach[8];
+
+#define LPC_TIM0 ( & sim_tim[0])
+#define LPC_TIM1 ( & sim_tim[1])
+#define LPC_TIM2 ( & sim_tim[2])
+#define LPC_TIM3 ( & sim_tim[3])
+#define LPC_ADC ( & sim_adc)
+#define LPC_SSP1 ( & sim_ssp1)
+#define LPC_I2C2 ( & sim_i2c2)
+#define LPC_UART3 ( & sim_uart3)
+#define LPC_GPDMA ( & sim_gpdma)
+#define LPC_GPDMACH0 ( & sim_gpdmach[0])
+#define LPC_GPDMACH1 ( & sim_gpdmach[1])
+#define LPC_GPDMACH2 ( & sim_gpdmach[2])
+#define LPC_GPDMACH3 ( & sim_gpdmach[3])
+#define LPC_GPDMACH4 ( & sim_gpdmach[4])
+#define LPC_GPDMACH5 ( & sim_gpdmach[5])
+#define LPC_GPDMACH6 ( & sim_gpdmach[6])
+#define LPC_GPDMACH7 ( & sim_gpdmach[7])
+
+/*
+ * DWT cycle counter. On the host it counts SystemCoreClock cycles of
+ * the monotonic clock, so profiling reports keep the target's unit.
+ */
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+  volatile uint32_t DEMCR;
+} sim_dwt_t;
+
+extern sim_dwt_t sim_dwt;
+volatile uint32_t * sim_cyccnt(void);
+
+#define DWT_CTRL (sim_dwt.CTRL)
+#define DWT_CYCCNT ( * sim_cyccnt())
+#define DEMCR (sim_dwt.DEMCR)
+
+extern uint32_t SystemCoreClock;
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t SysTick_Config(uint32_t ticks);
+
+void __enable_irq(void);
+void __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __WFI(void);
+void __NOP(void);
+void __DSB(void);
+void __DMB(void);
+
+#endif
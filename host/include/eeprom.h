@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the EA base board 24LC128 EEPROM driver.
+ */
+#ifndef __EEPROM_H
+#define __EEPROM_H
+
+#include <stdint.h>
+
+void eeprom_init(void);
+int16_t eeprom_read(uint8_t * buf, uint16_t offset, uint16_t len);
+int16_t eeprom_write(uint8_t * buf, uint16_t offset, uint16_t len);
+
+#endif
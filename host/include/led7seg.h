@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the EA base board 7-segment display driver.
+ */
+#ifndef __LED7SEG_H
+#define __LED7SEG_H
+
+#include <stdint.h>
+
+void led7seg_init(void);
+void led7seg_setChar(uint8_t ch, uint32_t rawMode);
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for the EA base board ISL29003 light sensor driver.
+ */
+#ifndef __LIGHT_H
+#define __LIGHT_H
+
+#include <stdint.h>
+
+typedef enum {
+  LIGHT_MODE_D1 = 0,
+  LIGHT_MODE_D2,
+  LIGHT_MODE_D1D2
+} light_mode_t;
+
+typedef enum {
+  LIGHT_RANGE_1000 = 0,
+  LIGHT_RANGE_4000,
+  LIGHT_RANGE_16000,
+  LIGHT_RANGE_64000
+} light_range_t;
+
+void light_init(void);
+void light_enable(void);
+uint32_t light_read(void);
+void light_setMode(light_mode_t mode);
+void light_setRange(light_range_t newRange);
+void light_shutdown(void);
+
+#endif
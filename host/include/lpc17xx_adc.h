@@ -0,0 +1,55 @@
+/*
+ * Host stand-in for the Lib_MCU ADC driver.
+ */
+#ifndef LPC17XX_ADC_H_
+#define LPC17XX_ADC_H_
+
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+#define ADC_DR_RESULT(n) (((n) >> 4) & 0xfff)
+#define ADC_DR_OVERRUN_FLAG (1UL << 30)
+#define ADC_DR_DONE_FLAG (1UL << 31)
+#define ADC_GDR_RESULT(n) (((n) >> 4) & 0xfff)
+#define ADC_GDR_CH(n) (((n) >> 24) & 0x7)
+#define ADC_GDR_OVERRUN_FLAG (1UL << 30)
+#define ADC_GDR_DONE_FLAG (1UL << 31)
+
+#define ADC_START_CONTINUOUS 0
+#define ADC_START_NOW 1
+#define ADC_DATA_BURST 0
+#define ADC_DATA_DONE 1
+
+typedef enum {
+  ADC_CHANNEL_0 = 0,
+  ADC_CHANNEL_1,
+  ADC_CHANNEL_2,
+  ADC_CHANNEL_3,
+  ADC_CHANNEL_4,
+  ADC_CHANNEL_5,
+  ADC_CHANNEL_6,
+  ADC_CHANNEL_7
+} ADC_CHANNEL_SELECTION;
+
+typedef enum {
+  ADC_ADINTEN0 = 0,
+  ADC_ADINTEN1,
+  ADC_ADINTEN2,
+  ADC_ADINTEN3,
+  ADC_ADINTEN4,
+  ADC_ADINTEN5,
+  ADC_ADINTEN6,
+  ADC_ADINTEN7,
+  ADC_ADGINTEN
+} ADC_TYPE_INT_OPT;
+
+void ADC_Init(LPC_ADC_TypeDef * ADCx, uint32_t rate);
+void ADC_BurstCmd(LPC_ADC_TypeDef * ADCx, FunctionalState NewState);
+void ADC_StartCmd(LPC_ADC_TypeDef * ADCx, uint8_t start_mode);
+void ADC_IntConfig(LPC_ADC_TypeDef * ADCx, ADC_TYPE_INT_OPT IntType, FunctionalState NewState);
+void ADC_ChannelCmd(LPC_ADC_TypeDef * ADCx, uint8_t Channel, FunctionalState NewState);
+uint16_t ADC_ChannelGetData(LPC_ADC_TypeDef * ADCx, uint8_t channel);
+FlagStatus ADC_ChannelGetStatus(LPC_ADC_TypeDef * ADCx, uint8_t channel, uint32_t StatusType);
+uint32_t ADC_GlobalGetData(LPC_ADC_TypeDef * ADCx);
+
+#endif
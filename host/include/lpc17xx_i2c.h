@@ -0,0 +1,40 @@
+/*
+ * Host stand-in for the Lib_MCU I2C driver, master mode only.
+ */
+#ifndef LPC17XX_I2C_H_
+#define LPC17XX_I2C_H_
+
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+#define I2C_SETUP_STATUS_ARBF (1 << 8)
+#define I2C_SETUP_STATUS_NOACKF (1 << 9)
+#define I2C_SETUP_STATUS_DONE (1 << 10)
+
+typedef struct {
+  uint32_t sl_addr7bit;
+  uint8_t * tx_data;
+  uint32_t tx_length;
+  uint32_t tx_count;
+  uint8_t * rx_data;
+  uint32_t rx_length;
+  uint32_t rx_count;
+  uint32_t retransmissions_max;
+  uint32_t retransmissions_count;
+  uint32_t status;
+  void (*callback)(void);
+} I2C_M_SETUP_Type;
+
+typedef enum {
+  I2C_TRANSFER_POLLING = 0,
+  I2C_TRANSFER_INTERRUPT
+} I2C_TRANSFER_OPT_Type;
+
+void I2C_Init(LPC_I2C_TypeDef * I2Cx, uint32_t clockrate);
+void I2C_Cmd(LPC_I2C_TypeDef * I2Cx, FunctionalState NewState);
+void I2C_IntCmd(LPC_I2C_TypeDef * I2Cx, Bool NewState);
+Status I2C_MasterTransferData(LPC_I2C_TypeDef * I2Cx, I2C_M_SETUP_Type * TransferCfg, I2C_TRANSFER_OPT_Type Opt);
+void I2C_MasterHandler(LPC_I2C_TypeDef * I2Cx);
+uint32_t I2C_MasterTransferComplete(LPC_I2C_TypeDef * I2Cx);
+
+#endif
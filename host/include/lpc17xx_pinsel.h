@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the Lib_MCU pin connect driver. Pin functions are
+ * not simulated, configuring a pin does nothing.
+ */
+#ifndef LPC17XX_PINSEL_H_
+#define LPC17XX_PINSEL_H_
+
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+typedef struct {
+  uint8_t Portnum;
+  uint8_t Pinnum;
+  uint8_t Funcnum;
+  uint8_t Pinmode;
+  uint8_t OpenDrain;
+} PINSEL_CFG_Type;
+
+void PINSEL_ConfigPin(PINSEL_CFG_Type * PinCfg);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Host stand-in for the Lib_MCU SSP driver.
+ */
+#ifndef LPC17XX_SSP_H_
+#define LPC17XX_SSP_H_
+
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+#define SSP_DATABIT_8 7
+#define SSP_CPHA_FIRST 0
+#define SSP_CPOL_HI 0
+#define SSP_MASTER_MODE 0
+#define SSP_FRAME_SPI 0
+
+#define SSP_STAT_TXFIFO_EMPTY (1 << 0)
+#define SSP_STAT_TXFIFO_NOTFULL (1 << 1)
+#define SSP_STAT_RXFIFO_NOTEMPTY (1 << 2)
+#define SSP_STAT_RXFIFO_FULL (1 << 3)
+#define SSP_STAT_BUSY (1 << 4)
+
+#define SSP_DMA_RX (1 << 0)
+#define SSP_DMA_TX (1 << 1)
+
+typedef struct {
+  uint32_t Databit;
+  uint32_t CPHA;
+  uint32_t CPOL;
+  uint32_t Mode;
+  uint32_t FrameFormat;
+  uint32_t ClockRate;
+} SSP_CFG_Type;
+
+typedef struct {
+  void * tx_data;
+  uint32_t tx_cnt;
+  void * rx_data;
+  uint32_t rx_cnt;
+  uint32_t length;
+  uint32_t status;
+} SSP_DATA_SETUP_Type;
+
+typedef enum {
+  SSP_TRANSFER_POLLING = 0,
+  SSP_TRANSFER_INTERRUPT
+} SSP_TRANSFER_Type;
+
+void SSP_ConfigStructInit(SSP_CFG_Type * SSP_InitStruct);
+void SSP_Init(LPC_SSP_TypeDef * SSPx, SSP_CFG_Type * SSP_ConfigStruct);
+void SSP_Cmd(LPC_SSP_TypeDef * SSPx, FunctionalState NewState);
+void SSP_SendData(LPC_SSP_TypeDef * SSPx, uint16_t Data);
+uint16_t SSP_ReceiveData(LPC_SSP_TypeDef * SSPx);
+int32_t SSP_ReadWrite(LPC_SSP_TypeDef * SSPx, SSP_DATA_SETUP_Type * dataCfg, SSP_TRANSFER_Type xfType);
+FlagStatus SSP_GetStatus(LPC_SSP_TypeDef * SSPx, uint32_t FlagType);
+void SSP_DMACmd(LPC_SSP_TypeDef * SSPx, uint32_t DMAMode, FunctionalState NewState);
+
+#endif
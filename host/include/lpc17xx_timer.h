@@ -0,0 +1,66 @@
+/*
+ * Host stand-in for the Lib_MCU timer driver, timer mode with the
+ * microsecond prescaler only.
+ */
+#ifndef LPC17XX_TIMER_H_
+#define LPC17XX_TIMER_H_
+
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+typedef enum {
+  TIM_TIMER_MODE = 0,
+  TIM_COUNTER_RISING_MODE,
+  TIM_COUNTER_FALLING_MODE,
+  TIM_COUNTER_ANY_MODE
+} TIM_MODE_OPT;
+
+typedef enum {
+  TIM_PRESCALE_TICKVAL = 0,
+  TIM_PRESCALE_USVAL
+} TIM_PRESCALE_OPT;
+
+typedef enum {
+  TIM_MR0_INT = 0,
+  TIM_MR1_INT,
+  TIM_MR2_INT,
+  TIM_MR3_INT,
+  TIM_CR0_INT,
+  TIM_CR1_INT
+} TIM_INT_TYPE;
+
+typedef enum {
+  TIM_EXTMATCH_NOTHING = 0,
+  TIM_EXTMATCH_LOW,
+  TIM_EXTMATCH_HIGH,
+  TIM_EXTMATCH_TOGGLE
+} TIM_EXTMATCH_OPT;
+
+typedef struct {
+  uint8_t PrescaleOption;
+  uint8_t Reserved[3];
+  uint32_t PrescaleValue;
+} TIM_TIMERCFG_Type;
+
+typedef struct {
+  uint8_t MatchChannel;
+  uint8_t IntOnMatch;
+  uint8_t StopOnMatch;
+  uint8_t ResetOnMatch;
+  uint8_t ExtMatchOutputType;
+  uint8_t Reserved[3];
+  uint32_t MatchValue;
+} TIM_MATCHCFG_Type;
+
+void TIM_Init(LPC_TIM_TypeDef * TIMx, TIM_MODE_OPT TimerCounterMode, void * TIM_ConfigStruct);
+void TIM_Cmd(LPC_TIM_TypeDef * TIMx, FunctionalState NewState);
+void TIM_ResetCounter(LPC_TIM_TypeDef * TIMx);
+void TIM_ConfigMatch(LPC_TIM_TypeDef * TIMx, TIM_MATCHCFG_Type * TIM_MatchConfigStruct);
+void TIM_UpdateMatchValue(LPC_TIM_TypeDef * TIMx, uint8_t MatchChannel, uint32_t MatchValue);
+void TIM_ClearIntPending(LPC_TIM_TypeDef * TIMx, TIM_INT_TYPE IntFlag);
+FlagStatus TIM_GetIntStatus(LPC_TIM_TypeDef * TIMx, TIM_INT_TYPE IntFlag);
+
+void Timer0_Wait(uint32_t time);
+void Timer0_us_Wait(uint32_t time);
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * Host stand-in for the Lib_MCU UART driver, transmit side only.
+ */
+#ifndef LPC17XX_UART_H_
+#define LPC17XX_UART_H_
+
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+#define UART_IIR_INTSTAT_PEND (1 << 0)
+#define UART_IIR_INTID_RDA (2 << 1)
+#define UART_IIR_INTID_THRE (1 << 1)
+#define UART_IIR_INTID_MASK (7 << 1)
+#define UART_LSR_THRE (1 << 5)
+#define UART_LSR_TEMT (1 << 6)
+#define UART_TX_FIFO_SIZE 16
+
+typedef enum {
+  UART_DATABIT_5 = 0,
+  UART_DATABIT_6,
+  UART_DATABIT_7,
+  UART_DATABIT_8
+} UART_DATABIT_Type;
+
+typedef enum {
+  UART_STOPBIT_1 = 0,
+  UART_STOPBIT_2
+} UART_STOPBIT_Type;
+
+typedef enum {
+  UART_PARITY_NONE = 0,
+  UART_PARITY_ODD,
+  UART_PARITY_EVEN,
+  UART_PARITY_SP_1,
+  UART_PARITY_SP_0
+} UART_PARITY_Type;
+
+typedef enum {
+  UART_FIFO_TRGLEV0 = 0,
+  UART_FIFO_TRGLEV1,
+  UART_FIFO_TRGLEV2,
+  UART_FIFO_TRGLEV3
+} UART_FITO_LEVEL_Type;
+
+typedef enum {
+  UART_INTCFG_RBR = 0,
+  UART_INTCFG_THRE,
+  UART_INTCFG_RLS
+} UART_INT_Type;
+
+typedef struct {
+  uint32_t Baud_rate;
+  UART_PARITY_Type Parity;
+  UART_DATABIT_Type Databits;
+  UART_STOPBIT_Type Stopbits;
+} UART_CFG_Type;
+
+typedef struct {
+  FunctionalState FIFO_ResetRxBuf;
+  FunctionalState FIFO_ResetTxBuf;
+  FunctionalState FIFO_DMAMode;
+  UART_FITO_LEVEL_Type FIFO_Level;
+} UART_FIFO_CFG_Type;
+
+void UART_ConfigStructInit(UART_CFG_Type * UART_InitStruct);
+void UART_Init(LPC_UART_TypeDef * UARTx, UART_CFG_Type * UART_ConfigStruct);
+void UART_FIFOConfigStructInit(UART_FIFO_CFG_Type * UART_FIFOInitStruct);
+void UART_FIFOConfig(LPC_UART_TypeDef * UARTx, UART_FIFO_CFG_Type * FIFOCfg);
+void UART_TxCmd(LPC_UART_TypeDef * UARTx, FunctionalState NewState);
+void UART_IntConfig(LPC_UART_TypeDef * UARTx, UART_INT_Type UARTIntCfg, FunctionalState NewState);
+void UART_SendByte(LPC_UART_TypeDef * UARTx, uint8_t Data);
+uint32_t UART_GetIntId(LPC_UART_TypeDef * UARTx);
+uint8_t UART_GetLineStatus(LPC_UART_TypeDef * UARTx);
+
+#endif
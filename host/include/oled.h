@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the EA base board SSD1305 OLED driver.
+ */
+#ifndef __OLED_H
+#define __OLED_H
+
+#include <stdint.h>
+
+#define OLED_DISPLAY_WIDTH 96
+#define OLED_DISPLAY_HEIGHT 64
+
+typedef enum {
+  OLED_COLOR_BLACK,
+  OLED_COLOR_WHITE
+} oled_color_t;
+
+void oled_init(void);
+void oled_putPixel(uint8_t x, uint8_t y, oled_color_t color);
+void oled_clearScreen(oled_color_t color);
+
+#endif
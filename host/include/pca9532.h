@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the EA base board PCA9532 LED driver.
+ */
+#ifndef __PCA9532_H
+#define __PCA9532_H
+
+#include <stdint.h>
+
+void pca9532_init(void);
+void pca9532_setLeds(uint16_t ledOnMask, uint16_t ledOffMask);
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * The Embedded Artists base board drivers, on top of the simulated
+ * buses. Like the originals they block: I2C goes out polled, the
+ * EEPROM waits out its write cycle, temp_read() counts half periods of
+ * the MAX6576 output for about half a second.
+ */
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "lpc17xx_gpio.h"
+#include "lpc17xx_pinsel.h"
+#include "lpc17xx_ssp.h"
+#include "lpc17xx_timer.h"
+#include "acc.h"
+#include "eeprom.h"
+#include "led7seg.h"
+#include "light.h"
+#include "oled.h"
+#include "pca9532.h"
+#include "temp.h"
+#include "sim.h"
+
+#define EEPROM_ADDR 0x50
+#define PCA9532_ADDR 0x60
+#define LIGHT_ADDR 0x44
+#define ACC_ADDR 0x1d
+#define TEMP_HALF_PERIODS 340
+
+static uint32_t (* temp_ticks)(void);
+static uint16_t pca_shadow;
+static uint8_t light_cmd;
+static uint8_t light_ctrl;
+static uint8_t acc_mctl;
+
+void sim_reset(void) {
+  uint16_t wear[SIM_EEPROM_PAGES];
+  uint32_t cycle = sim.eeprom.write_cycle_us;
+  uint8_t * out = sim.uart.out;
+  uint32_t cap = sim.uart.cap;
+
+  // habenjeto i sodrzinata na EEPROM go prezivuvaat resetot
+  memcpy(wear, sim.eeprom.wear, sizeof(wear));
+  memset( & sim, 0, sizeof(sim));
+  memcpy(sim.eeprom.wear, wear, sizeof(wear));
+  sim.eeprom.write_cycle_us = cycle;
+  sim.uart.out = out;
+  sim.uart.cap = cap;
+
+  sim.temp = 250;
+  sim.lux = 100;
+  sim.pot = 2048;
+
+  sim_core_reset();
+  sim_periph_reset();
+  sim_i2c_reset();
+  sim_board_reset();
+}
+
+void sim_board_reset(void) {
+  temp_ticks = NULL;
+  pca_shadow = 0;
+  light_cmd = 0;
+  light_ctrl = 0;
+  acc_mctl = 0;
+}
+
+void PINSEL_ConfigPin(PINSEL_CFG_Type * PinCfg) {
+  (void) PinCfg;
+}
+
+void Timer0_Wait(uint32_t time) {
+  sim_delay(time * 1000);
+}
+
+void Timer0_us_Wait(uint32_t time) {
+  sim_delay(time);
+}
+
+/* ---- 24LC128 ---- */
+
+void eeprom_init(void) {
+}
+
+int16_t eeprom_read(uint8_t * buf, uint16_t offset, uint16_t len) {
+  uint8_t a[2] = {offset >> 8, offset & 0xff};
+  if (sim_i2c_blocking(EEPROM_ADDR, a, 2, buf, len)) {
+    memset(buf, 0xff, len);
+    return 0;
+  }
+  return len;
+}
+
+// po strani, so cekanje na ciklusot za zapis preku potvrdata na adresata
+int16_t eeprom_write(uint8_t * buf, uint16_t offset, uint16_t len) {
+  uint16_t done = 0;
+  while (done < len) {
+    uint8_t tx[2 + SIM_EEPROM_PAGE];
+    uint16_t a = offset + done;
+    uint16_t n = SIM_EEPROM_PAGE - (a % SIM_EEPROM_PAGE);
+    if (n > len - done)
+      n = len - done;
+    tx[0] = a >> 8;
+    tx[1] = a & 0xff;
+    memcpy( & tx[2], buf + done, n);
+    while (sim_i2c_blocking(EEPROM_ADDR, tx, n + 2, NULL, 0))
+      ;
+    done += n;
+  }
+  return len;
+}
+
+/* ---- PCA9532 ---- */
+
+void pca9532_init(void) {
+}
+
+void pca9532_setLeds(uint16_t ledOnMask, uint16_t ledOffMask) {
+  uint8_t tx[5];
+
+  pca_shadow &= ~ledOffMask;
+  pca_shadow |= ledOnMask;
+  tx[0] = 0x16; // LS0 so avtomatsko zgolemuvanje
+  for (int i = 0; i < 4; i++) {
+    tx[i + 1] = 0;
+    for (int k = 0; k < 4; k++)
+      if (pca_shadow & (1 << (i * 4 + k)))
+        tx[i + 1] |= 1 << (k * 2);
+  }
+  sim_i2c_blocking(PCA9532_ADDR, tx, sizeof(tx), NULL, 0);
+}
+
+/* ---- ISL29003 ---- */
+
+static uint32_t light_range_lux(void) {
+  static const uint32_t ranges[4] = {1000, 4000, 16000, 64000};
+  return ranges[(light_ctrl >> 2) & 3];
+}
+
+static void light_write(uint8_t reg, uint8_t v) {
+  uint8_t tx[2] = {reg, v};
+  sim_i2c_blocking(LIGHT_ADDR, tx, 2, NULL, 0);
+}
+
+void light_init(void) {
+}
+
+void light_enable(void) {
+  light_cmd |= 0x80;
+  light_write(0, light_cmd);
+}
+
+uint32_t light_read(void) {
+  uint8_t reg = 4;
+  uint8_t rx[2];
+  if (sim_i2c_blocking(LIGHT_ADDR, & reg, 1, rx, 2))
+    return 0;
+  return (light_range_lux() * (uint32_t) ((rx[1] << 8) | rx[0])) >> 16;
+}
+
+void light_setMode(light_mode_t mode) {
+  light_cmd = (light_cmd & ~0x0c) | ((mode & 3) << 2);
+  light_write(0, light_cmd);
+}
+
+void light_setRange(light_range_t newRange) {
+  light_ctrl = (light_ctrl & ~0x0c) | ((newRange & 3) << 2);
+  light_write(1, light_ctrl);
+}
+
+void light_shutdown(void) {
+  light_cmd &= ~0x80;
+  light_write(0, light_cmd);
+}
+
+/* ---- MMA7455 ---- */
+
+static void acc_write(uint8_t reg, uint8_t v) {
+  uint8_t tx[2] = {reg, v};
+  sim_i2c_blocking(ACC_ADDR, tx, 2, NULL, 0);
+}
+
+void acc_init(void) {
+  acc_mctl = 0x05; // merenje, 2g
+  acc_write(0x16, acc_mctl);
+}
+
+void acc_read(int8_t * x, int8_t * y, int8_t * z) {
+  uint8_t reg = 0x06;
+  uint8_t rx[3] = {0, 0, 0};
+  sim_i2c_blocking(ACC_ADDR, & reg, 1, rx, 3);
+  * x = (int8_t) rx[0];
+  * y = (int8_t) rx[1];
+  * z = (int8_t) rx[2];
+}
+
+void acc_setRange(acc_range_t range) {
+  static const uint8_t glvl[3] = {0x00, 0x04, 0x08};
+  acc_mctl = (acc_mctl & ~0x0c) | glvl[range];
+  acc_write(0x16, acc_mctl);
+}
+
+void acc_setMode(acc_mode_t mode) {
+  acc_mctl = (acc_mctl & ~0x03) | (mode & 3);
+  acc_write(0x16, acc_mctl);
+}
+
+/* ---- MAX6576 ---- */
+
+void temp_init(uint32_t (* getMsTicks)(void)) {
+  temp_ticks = getMsTicks;
+}
+
+/*
+ * Same arithmetic as the EA driver: the time of 340 half periods in
+ * milliseconds, so the result moves in steps of about 0.6 C.
+ */
+int32_t temp_read(void) {
+  uint32_t period = 2731 + sim.temp;
+  uint32_t phase = (uint32_t) (sim_now() % period);
+  uint32_t t1, t2;
+
+  // prv rab
+  sim_delay(phase < period / 2 ? period / 2 - phase : period - phase);
+  t1 = temp_ticks();
+  sim_delay(TEMP_HALF_PERIODS / 2 * period);
+  t2 = temp_ticks() - t1;
+  return ((2 * 1000 * t2) / TEMP_HALF_PERIODS - 2731);
+}
+
+/* ---- OLED and 7-segment ---- */
+
+void oled_init(void) {
+  GPIO_SetDir(0, 1 << 6, 1);
+  GPIO_SetDir(2, 1 << 7, 1);
+  GPIO_SetValue(0, 1 << 6);
+  memset(sim.oled.ram, 0, sizeof(sim.oled.ram));
+}
+
+void oled_putPixel(uint8_t x, uint8_t y, oled_color_t color) {
+  uint8_t * b = & sim.oled.ram[y / 8][x + SIM_OLED_X_OFFSET];
+  sim_delay(4 * sim_ssp_byte_us());
+  if (color == OLED_COLOR_WHITE) * b |= 1 << (y % 8);
+  else * b &= ~(1 << (y % 8));
+}
+
+void oled_clearScreen(oled_color_t color) {
+  sim_delay(SIM_OLED_PAGES * (3 + SIM_OLED_COLUMNS) * sim_ssp_byte_us());
+  memset(sim.oled.ram, color == OLED_COLOR_WHITE ? 0xff : 0, sizeof(sim.oled.ram));
+}
+
+void led7seg_init(void) {
+  GPIO_SetDir(2, 1 << 2, 1);
+  GPIO_SetValue(2, 1 << 2);
+}
+
+void led7seg_setChar(uint8_t ch, uint32_t rawMode) {
+  SSP_DATA_SETUP_Type xfer;
+  (void) rawMode;
+
+  xfer.tx_data = & ch;
+  xfer.rx_data = NULL;
+  xfer.length = 1;
+  GPIO_ClearValue(2, 1 << 2);
+  SSP_ReadWrite(LPC_SSP1, & xfer, SSP_TRANSFER_POLLING);
+  GPIO_SetValue(2, 1 << 2);
+  sim.seg.ch = ch;
+}
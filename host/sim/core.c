@@ -0,0 +1,455 @@
+/*
+ * Virtual clock, NVIC and the four timers.
+ *
+ * The clock only moves forward from __WFI(), sim_delay() and the status
+ * polls (sim_spin). Each step goes to the earliest event any device has
+ * scheduled, fires it, and lets pending interrupts run unless PRIMASK is
+ * set or a handler is already running.
+ */
+#define _GNU_SOURCE
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "LPC17xx.h"
+#include "lpc17xx_timer.h"
+#include "sim.h"
+
+#define STORM_LIMIT 100 // obrabotki po red bez pomestuvanje na vremeto
+
+sim_t sim;
+uint32_t SystemCoreClock = 100000000;
+sim_dwt_t sim_dwt;
+LPC_TIM_TypeDef sim_tim[4];
+
+static uint64_t now_us;
+static uint32_t pending; // po IRQn + 1
+static uint32_t enabled;
+static uint32_t primask;
+static int in_isr;
+static uint32_t systick_us;
+static uint64_t systick_next;
+static uint64_t host_mark;
+static uint64_t cpu_frac;
+
+static uint32_t tim_us[4]; // mikrosekundi po otcukuvanje
+static uint32_t tim_sub[4];
+static uint8_t tim_wrap[4]; // TC se vraka na 0 na slednoto otcukuvanje
+static uint8_t tim_tick[4]; // TC otcukal, sovpagjanjata se uste ne se provereni
+
+/*
+ * Firmware handlers. The host build has no startup file, so every vector
+ * the firmware does not define falls back to a weak default that stops
+ * the run, which is what the target's IntDefaultHandler loop amounts to.
+ */
+#define WEAK_HANDLER(name) \
+  void name(void) __attribute__((weak)); \
+  void name(void) { sim_fault("unhandled " #name); }
+
+WEAK_HANDLER(SysTick_Handler)
+WEAK_HANDLER(TIMER0_IRQHandler)
+WEAK_HANDLER(TIMER1_IRQHandler)
+WEAK_HANDLER(TIMER2_IRQHandler)
+WEAK_HANDLER(TIMER3_IRQHandler)
+WEAK_HANDLER(UART3_IRQHandler)
+WEAK_HANDLER(I2C2_IRQHandler)
+WEAK_HANDLER(EINT3_IRQHandler)
+WEAK_HANDLER(ADC_IRQHandler)
+WEAK_HANDLER(DMA_IRQHandler)
+
+static void (* vector(int irqn))(void) {
+  switch (irqn) {
+    case SysTick_IRQn: return SysTick_Handler;
+    case TIMER0_IRQn: return TIMER0_IRQHandler;
+    case TIMER1_IRQn: return TIMER1_IRQHandler;
+    case TIMER2_IRQn: return TIMER2_IRQHandler;
+    case TIMER3_IRQn: return TIMER3_IRQHandler;
+    case UART3_IRQn: return UART3_IRQHandler;
+    case I2C2_IRQn: return I2C2_IRQHandler;
+    case EINT3_IRQn: return EINT3_IRQHandler;
+    case ADC_IRQn: return ADC_IRQHandler;
+    case DMA_IRQn: return DMA_IRQHandler;
+  }
+  return 0;
+}
+
+// nivo na linijata na uredot, za povtorno postavuvanje po obrabotkata
+static int line(int irqn) {
+  switch (irqn) {
+    case TIMER0_IRQn:
+    case TIMER1_IRQn:
+    case TIMER2_IRQn:
+    case TIMER3_IRQn: return sim_timer_line(irqn - TIMER0_IRQn);
+    case UART3_IRQn: return sim_uart_line();
+    case I2C2_IRQn: return sim_i2c_line();
+    case EINT3_IRQn: return sim_gpio_line();
+    case ADC_IRQn: return sim_adc_line();
+    case DMA_IRQn: return sim_dma_line();
+  }
+  return 0;
+}
+
+void sim_fault(const char * fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  fprintf(stderr, "sim: ");
+  vfprintf(stderr, fmt, ap);
+  fprintf(stderr, " at %llu us\n", (unsigned long long) now_us);
+  va_end(ap);
+  abort();
+}
+
+static uint64_t host_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, & ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+uint64_t sim_now(void) {
+  return now_us;
+}
+
+void sim_irq(int irqn) {
+  pending |= 1u << (irqn + 1);
+}
+
+/*
+ * Takes the pending, enabled interrupts one at a time. Peripheral IRQs
+ * go in IRQn order and SysTick last, which is how the NVIC orders them
+ * when SysTick sits at the lowest priority and the rest share one.
+ */
+static void dispatch(void) {
+  static uint64_t storm_at;
+  static int storm_irq;
+  static uint32_t storm_count;
+
+  while (!primask && !in_isr && (pending & enabled)) {
+    uint32_t ready = pending & enabled;
+    int irqn;
+    if (ready & ~1u) irqn = __builtin_ctz(ready & ~1u) - 1;
+    else irqn = SysTick_IRQn;
+
+    pending &= ~(1u << (irqn + 1));
+    sim.core.count[irqn + 1]++;
+    in_isr = 1;
+    vector(irqn)();
+    in_isr = 0;
+
+    if (line(irqn)) {
+      if (storm_irq == irqn && storm_at == now_us) {
+        if (++storm_count == STORM_LIMIT) {
+          // na plocata jadroto nikogas ne bi izleglo od prekinot
+          sim.core.storms++;
+          continue;
+        }
+        if (storm_count > STORM_LIMIT) continue;
+      } else {
+        storm_irq = irqn;
+        storm_at = now_us;
+        storm_count = 0;
+      }
+      sim_irq(irqn);
+    }
+  }
+}
+
+/* ---- timers ---- */
+
+static int tim_index(LPC_TIM_TypeDef * TIMx) {
+  int n = (int) (TIMx - sim_tim);
+  if (n < 0 || n > 3) sim_fault("bad timer");
+  return n;
+}
+
+static volatile uint32_t * tim_mr(int n, int ch) {
+  return & sim_tim[n].MR0 + ch;
+}
+
+// mikrosekundi do sovpagjanjeto na kanalot ch, UINT64_MAX ako nema
+static uint64_t tim_due(int n, int ch) {
+  LPC_TIM_TypeDef * t = & sim_tim[n];
+  uint64_t ticks;
+  if (!(t->TCR & 1) || !tim_us[n]) return UINT64_MAX;
+  if (!((t->MCR >> (3 * ch)) & 7)) return UINT64_MAX;
+  if (tim_wrap[n]) ticks = (uint64_t) * tim_mr(n, ch) + 1;
+  else ticks = (uint32_t) (* tim_mr(n, ch) - t->TC);
+  if (ticks == 0) {
+    // TC stignal do MR: sovpagjanje sega, ili po cel krug ako e veke obraboteno
+    if (tim_tick[n]) return 0;
+    ticks = 1ull << 32;
+  }
+  return ticks * tim_us[n] - tim_sub[n];
+}
+
+uint64_t sim_timers_next(void) {
+  uint64_t next = UINT64_MAX;
+  int n, ch;
+  for (n = 0; n < 4; n++)
+    for (ch = 0; ch < 4; ch++) {
+      uint64_t d = tim_due(n, ch);
+      if (d != UINT64_MAX && now_us + d < next) next = now_us + d;
+    }
+  return next;
+}
+
+void sim_timers_elapse(uint64_t us) {
+  int n;
+  for (n = 0; n < 4; n++) {
+    uint64_t ticks;
+    if (!(sim_tim[n].TCR & 1) || !tim_us[n]) continue;
+    ticks = (tim_sub[n] + us) / tim_us[n];
+    tim_sub[n] = (tim_sub[n] + us) % tim_us[n];
+    if (!ticks) continue;
+    tim_tick[n] = 1;
+    if (tim_wrap[n]) {
+      sim_tim[n].TC = 0;
+      tim_wrap[n] = 0;
+      ticks--;
+    }
+    sim_tim[n].TC += (uint32_t) ticks;
+  }
+}
+
+void sim_timers_fire(void) {
+  int n, ch;
+  for (n = 0; n < 4; n++) {
+    LPC_TIM_TypeDef * t = & sim_tim[n];
+    int irq = 0, wrap = 0;
+    if (!(t->TCR & 1) || !tim_us[n] || !tim_tick[n] || tim_wrap[n]) continue;
+    tim_tick[n] = 0;
+    for (ch = 0; ch < 4; ch++) {
+      uint32_t mcr = (t->MCR >> (3 * ch)) & 7;
+      if (!mcr || * tim_mr(n, ch) != t->TC) continue;
+      if (mcr & 1) {
+        t->IR |= 1u << ch;
+        irq = 1;
+      }
+      if (mcr & 2) wrap = 1;
+      if (mcr & 4) t->TCR &= ~1u;
+    }
+    if (wrap) tim_wrap[n] = 1;
+    if (irq) sim_irq(TIMER0_IRQn + n);
+  }
+}
+
+int sim_timer_line(int n) {
+  return (sim_tim[n].IR & 0x3f) != 0;
+}
+
+void TIM_Init(LPC_TIM_TypeDef * TIMx, TIM_MODE_OPT TimerCounterMode, void * TIM_ConfigStruct) {
+  TIM_TIMERCFG_Type * cfg = TIM_ConfigStruct;
+  int n = tim_index(TIMx);
+  if (TimerCounterMode != TIM_TIMER_MODE || cfg->PrescaleOption != TIM_PRESCALE_USVAL || !cfg->PrescaleValue)
+    sim_fault("TIMER%d: only the microsecond prescaler is simulated", n);
+  memset((void *) TIMx, 0, sizeof(* TIMx));
+  tim_us[n] = cfg->PrescaleValue;
+  tim_sub[n] = 0;
+  tim_wrap[n] = 0;
+  tim_tick[n] = 0;
+}
+
+void TIM_Cmd(LPC_TIM_TypeDef * TIMx, FunctionalState NewState) {
+  if (NewState == ENABLE) TIMx->TCR |= 1;
+  else TIMx->TCR &= ~1u;
+}
+
+void TIM_ResetCounter(LPC_TIM_TypeDef * TIMx) {
+  int n = tim_index(TIMx);
+  TIMx->TC = 0;
+  tim_sub[n] = 0;
+  tim_wrap[n] = 0;
+  tim_tick[n] = 0;
+}
+
+void TIM_ConfigMatch(LPC_TIM_TypeDef * TIMx, TIM_MATCHCFG_Type * cfg) {
+  uint32_t ch = cfg->MatchChannel & 3;
+  uint32_t bits = (cfg->IntOnMatch ? 1 : 0) | (cfg->ResetOnMatch ? 2 : 0) | (cfg->StopOnMatch ? 4 : 0);
+  * tim_mr(tim_index(TIMx), ch) = cfg->MatchValue;
+  TIMx->MCR = (TIMx->MCR & ~(7u << (3 * ch))) | (bits << (3 * ch));
+}
+
+void TIM_UpdateMatchValue(LPC_TIM_TypeDef * TIMx, uint8_t MatchChannel, uint32_t MatchValue) {
+  * tim_mr(tim_index(TIMx), MatchChannel & 3) = MatchValue;
+}
+
+void TIM_ClearIntPending(LPC_TIM_TypeDef * TIMx, TIM_INT_TYPE IntFlag) {
+  TIMx->IR &= ~(1u << IntFlag);
+}
+
+FlagStatus TIM_GetIntStatus(LPC_TIM_TypeDef * TIMx, TIM_INT_TYPE IntFlag) {
+  return (TIMx->IR >> IntFlag) & 1 ? SET : RESET;
+}
+
+/* ---- clock ---- */
+
+static uint64_t next_event(void) {
+  uint64_t next = systick_us ? systick_next : UINT64_MAX;
+  uint64_t t = sim_timers_next();
+  if (t < next) next = t;
+  t = sim_i2c_next();
+  if (t < next) next = t;
+  t = sim_periph_next();
+  if (t < next) next = t;
+  return next;
+}
+
+static void elapse(uint64_t t) {
+  if (t <= now_us) return;
+  sim_timers_elapse(t - now_us);
+  now_us = t;
+}
+
+static void fire_due(void) {
+  if (systick_us && systick_next <= now_us) {
+    systick_next += systick_us;
+    sim_irq(SysTick_IRQn);
+  }
+  if (sim_timers_next() <= now_us) sim_timers_fire();
+  if (sim_i2c_next() <= now_us) sim_i2c_fire();
+  if (sim_periph_next() <= now_us) sim_periph_fire();
+}
+
+// do vremeto t, so obrabotka na prekinite po sekoj nastan
+static void run_until(uint64_t t) {
+  for (;;) {
+    uint64_t at = next_event();
+    if (at > t) break;
+    elapse(at);
+    fire_due();
+    dispatch();
+  }
+  elapse(t);
+  dispatch();
+}
+
+/*
+ * With cpu_scale set, the host time the firmware spends between two
+ * interrupt masks is charged to the virtual clock, so a slow main loop
+ * shows up as late deadlines the way it would on the board.
+ */
+static void charge(void) {
+  uint64_t ns, us;
+  if (!sim.cpu_scale || in_isr || primask) return;
+  ns = host_ns();
+  if (host_mark) cpu_frac += (ns - host_mark) * sim.cpu_scale;
+  host_mark = ns;
+  us = cpu_frac / 1000;
+  cpu_frac %= 1000;
+  if (us) {
+    sim.core.cpu_us += us;
+    run_until(now_us + us);
+    host_mark = host_ns();
+  }
+}
+
+void sim_delay(uint32_t us) {
+  sim.core.busy_us += us;
+  run_until(now_us + us);
+  host_mark = host_ns();
+}
+
+void sim_spin(void) {
+  sim.core.spin_us++;
+  run_until(now_us + 1);
+}
+
+volatile uint32_t * sim_cyccnt(void) {
+  if (sim_dwt.CTRL & 1) sim_dwt.CYCCNT = (uint32_t) (host_ns() * (SystemCoreClock / 1000000) / 1000);
+  return & sim_dwt.CYCCNT;
+}
+
+void sim_core_reset(void) {
+  now_us = 0;
+  pending = 0;
+  enabled = 1; // SysTick nema bit za dozvola vo NVIC
+  primask = 0;
+  in_isr = 0;
+  systick_us = 0;
+  host_mark = 0;
+  cpu_frac = 0;
+  memset(sim_tim, 0, sizeof(sim_tim));
+  memset(tim_us, 0, sizeof(tim_us));
+  memset(tim_sub, 0, sizeof(tim_sub));
+  memset(tim_wrap, 0, sizeof(tim_wrap));
+  memset(tim_tick, 0, sizeof(tim_tick));
+  memset(& sim_dwt, 0, sizeof(sim_dwt));
+}
+
+/* ---- core ---- */
+
+void NVIC_EnableIRQ(IRQn_Type IRQn) {
+  enabled |= 1u << (IRQn + 1);
+  if (line(IRQn)) sim_irq(IRQn);
+  dispatch();
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn) {
+  enabled &= ~(1u << (IRQn + 1));
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn) {
+  sim_irq(IRQn);
+  dispatch();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn) {
+  pending &= ~(1u << (IRQn + 1));
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority) {
+  (void) IRQn;
+  (void) priority;
+}
+
+uint32_t SysTick_Config(uint32_t ticks) {
+  systick_us = (uint32_t) ((uint64_t) ticks * 1000000 / SystemCoreClock);
+  if (!systick_us) return 1;
+  systick_next = now_us + systick_us;
+  return 0;
+}
+
+void __enable_irq(void) {
+  primask = 0;
+  dispatch();
+}
+
+void __disable_irq(void) {
+  charge();
+  primask = 1;
+}
+
+uint32_t __get_PRIMASK(void) {
+  return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask) {
+  primask = priMask & 1;
+  if (!primask) dispatch();
+}
+
+// budenjeto ne zavisi od PRIMASK, kako na jadroto
+void __WFI(void) {
+  uint64_t t0 = now_us;
+  if (in_isr) sim_fault("WFI inside an interrupt handler");
+  sim.core.wfi++;
+  while (!(pending & enabled)) {
+    uint64_t at = next_event();
+    if (at == UINT64_MAX) sim_fault("WFI with nothing left to wake it");
+    elapse(at);
+    fire_due();
+  }
+  sim.core.sleep_us += now_us - t0;
+  dispatch();
+  host_mark = host_ns();
+}
+
+void __NOP(void) {
+}
+
+void __DSB(void) {
+}
+
+void __DMB(void) {
+}
@@ -0,0 +1,406 @@
+/*
+ * I2C2 at 100 kHz and the four slaves on it: 24LC128 EEPROM, PCA9532
+ * LED driver, ISL29003 light sensor and MMA7455 accelerometer.
+ *
+ * A transfer takes nine bit times per byte plus start and stop. The
+ * slave answers (or NACKs its address) when the transfer starts and its
+ * registers change when it ends, which is when the EEPROM starts its
+ * write cycle and ignores the bus until it is over.
+ */
+#define _GNU_SOURCE
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "LPC17xx.h"
+#include "lpc17xx_i2c.h"
+#include "sim.h"
+
+#define BYTE_US 90
+#define STOP_US 20
+#define EEPROM_WRITE_US 5000
+
+LPC_I2C_TypeDef sim_i2c2;
+
+static uint8_t * eeprom_mem;
+static uint16_t eeprom_ptr;
+static uint64_t eeprom_ready; // kraj na ciklusot za zapis
+
+static uint8_t pca_reg[10];
+static uint8_t pca_ptr;
+
+static uint8_t light_reg[8];
+
+static uint8_t acc_reg[0x20];
+static uint8_t acc_ptr;
+static uint64_t acc_last; // posleden procitan primerok + 1
+
+static I2C_M_SETUP_Type * xfer;
+static uint64_t xfer_at; // sleden nastan na tekovniot prenos
+static int xfer_acked;
+static int line_high;
+static int complete;
+static int blocking;
+
+static uint32_t xfer_us(uint32_t tx_len, uint32_t rx_len) {
+  uint32_t us = (1 + tx_len) * BYTE_US + STOP_US;
+  if (rx_len)
+    us += (1 + rx_len) * BYTE_US;
+  return us;
+}
+
+uint8_t * sim_eeprom(void) {
+  if (!eeprom_mem) {
+    // deljiva so procesite od fork, za testovite so isklucuvanje
+    eeprom_mem = mmap(NULL, SIM_EEPROM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (eeprom_mem == MAP_FAILED)
+      sim_fault("eeprom mmap");
+    memset(eeprom_mem, 0xff, SIM_EEPROM_SIZE);
+  }
+  return eeprom_mem;
+}
+
+void sim_eeprom_erase(void) {
+  memset(sim_eeprom(), 0xff, SIM_EEPROM_SIZE);
+  memset(sim.eeprom.wear, 0, sizeof(sim.eeprom.wear));
+}
+
+/* ---- slaves ---- */
+
+static int acc_odr(void) {
+  return acc_reg[0x18] & 0x80 ? 250 : 125;
+}
+
+static uint64_t acc_sample(void) {
+  return sim_now() * acc_odr() / 1000000;
+}
+
+static int8_t acc_axis(int axis, uint64_t k) {
+  int v = sim.acc[axis];
+  if (axis == 2 && sim.acc_amp && sim.acc_hz)
+    v += (int) lround(sim.acc_amp * sin(2 * M_PI * sim.acc_hz * (double) k / acc_odr()));
+  if (v > 127) v = 127;
+  if (v < -128) v = -128;
+  return (int8_t) v;
+}
+
+static uint8_t acc_get(uint8_t reg) {
+  uint64_t k = acc_sample();
+  if ((acc_reg[0x16] & 3) != 1)
+    return reg < sizeof(acc_reg) ? acc_reg[reg] : 0;
+  switch (reg) {
+    case 0x06: return (uint8_t) acc_axis(0, k);
+    case 0x07: return (uint8_t) acc_axis(1, k);
+    case 0x08: return (uint8_t) acc_axis(2, k);
+    case 0x09: {
+      // DRDY za nov primerok, DOVR ako nekoj e prepisan pred citanjeto
+      uint8_t st = 0;
+      if (k + 1 > acc_last) st |= 0x01;
+      if (k > acc_last) st |= 0x02;
+      return st;
+    }
+  }
+  return reg < sizeof(acc_reg) ? acc_reg[reg] : 0;
+}
+
+static uint32_t light_range(void) {
+  static const uint32_t ranges[4] = {1000, 4000, 16000, 64000};
+  return ranges[(light_reg[1] >> 2) & 3];
+}
+
+static uint8_t light_get(uint8_t reg) {
+  uint64_t count = (uint64_t) sim.lux * 65536 / light_range();
+  if (count > 0xffff) count = 0xffff;
+  if (!(light_reg[0] & 0x80)) count = 0; // ADC isklucen
+  if (reg == 4) return count & 0xff;
+  if (reg == 5) return count >> 8;
+  return reg < sizeof(light_reg) ? light_reg[reg] : 0;
+}
+
+static void pca_update(void) {
+  uint16_t leds = 0;
+  for (int i = 0; i < 16; i++)
+    if (((pca_reg[6 + i / 4] >> ((i % 4) * 2)) & 3) == 1)
+      leds |= 1 << i;
+  sim.pca.leds = leds;
+}
+
+static void power_cut(void) {
+  if (sim.eeprom.power_off)
+    sim.eeprom.power_off();
+  _exit(0);
+}
+
+static void eeprom_write(const uint8_t * d, uint32_t n) {
+  uint8_t * mem = sim_eeprom();
+  uint16_t page = eeprom_ptr / SIM_EEPROM_PAGE;
+  uint32_t arrive = n;
+
+  sim.eeprom.page_writes++;
+  if (sim.eeprom.cut_at && sim.eeprom.page_writes == sim.eeprom.cut_at && sim.eeprom.cut_bytes < n)
+    arrive = sim.eeprom.cut_bytes;
+  // zapisot ostanuva vo ramkite na stranata
+  for (uint32_t i = 0; i < arrive; i++) {
+    uint16_t a = page * SIM_EEPROM_PAGE + (eeprom_ptr + i) % SIM_EEPROM_PAGE;
+    mem[a] = d[i];
+  }
+  if (arrive < n)
+    power_cut();
+  eeprom_ptr = page * SIM_EEPROM_PAGE + (eeprom_ptr + n) % SIM_EEPROM_PAGE;
+  sim.eeprom.bytes_written += n;
+  sim.eeprom.wear[page]++;
+  eeprom_ready = sim_now() + sim.eeprom.write_cycle_us;
+  sim.eeprom.busy_us += sim.eeprom.write_cycle_us;
+  if (sim.eeprom.cut_at && sim.eeprom.page_writes == sim.eeprom.cut_at)
+    power_cut();
+}
+
+// dali slave-ot ja potvrduva adresata
+static int slave_ack(uint8_t addr) {
+  switch (addr) {
+    case 0x50:
+      if (sim_now() < eeprom_ready) {
+        sim.eeprom.busy_nacks++;
+        return 0;
+      }
+      return 1;
+    case 0x60:
+    case 0x44:
+    case 0x1d:
+      return 1;
+  }
+  return 0;
+}
+
+static void slave_xfer(uint8_t addr, const uint8_t * tx, uint32_t tx_len, uint8_t * rx, uint32_t rx_len) {
+  uint32_t i;
+
+  switch (addr) {
+    case 0x50:
+      if (tx_len >= 2)
+        eeprom_ptr = ((tx[0] << 8) | tx[1]) & (SIM_EEPROM_SIZE - 1);
+      if (tx_len > 2)
+        eeprom_write(tx + 2, tx_len - 2);
+      if (rx_len) {
+        sim.eeprom.reads++;
+        for (i = 0; i < rx_len; i++) {
+          rx[i] = sim_eeprom()[eeprom_ptr];
+          eeprom_ptr = (eeprom_ptr + 1) & (SIM_EEPROM_SIZE - 1);
+        }
+      }
+      break;
+
+    case 0x60:
+      if (tx_len)
+        pca_ptr = tx[0];
+      for (i = 1; i < tx_len; i++) {
+        uint8_t r = pca_ptr & 0x0f;
+        if (r < sizeof(pca_reg))
+          pca_reg[r] = tx[i];
+        if (pca_ptr & 0x10)
+          pca_ptr = (pca_ptr & 0x10) | ((r + 1) & 0x0f);
+      }
+      if (tx_len > 1) {
+        sim.pca.writes++;
+        pca_update();
+      }
+      for (i = 0; i < rx_len; i++) {
+        uint8_t r = pca_ptr & 0x0f;
+        rx[i] = r < sizeof(pca_reg) ? pca_reg[r] : 0;
+        if (pca_ptr & 0x10)
+          pca_ptr = (pca_ptr & 0x10) | ((r + 1) & 0x0f);
+      }
+      break;
+
+    case 0x44: {
+      uint8_t r = tx_len ? tx[0] : 0;
+      for (i = 1; i < tx_len; i++, r++)
+        if (r < sizeof(light_reg))
+          light_reg[r] = tx[i];
+      r = tx_len ? tx[0] : 0;
+      for (i = 0; i < rx_len; i++, r++)
+        rx[i] = light_get(r);
+      break;
+    }
+
+    case 0x1d: {
+      uint8_t r;
+      if (tx_len)
+        acc_ptr = tx[0];
+      r = acc_ptr;
+      for (i = 1; i < tx_len; i++, r++)
+        if (r < sizeof(acc_reg))
+          acc_reg[r] = tx[i];
+      if (tx_len > 1) {
+        sim.acc_dev.mctl = acc_reg[0x16];
+        sim.acc_dev.ctl1 = acc_reg[0x18];
+      }
+      if (rx_len) {
+        sim.acc_dev.reads++;
+        for (i = 0; i < rx_len; i++)
+          rx[i] = acc_get(r + i);
+        // citanjeto na Z go oslobaduva primerokot
+        if (r <= 0x08 && r + rx_len > 0x08) {
+          acc_last = acc_sample() + 1;
+          sim.acc_dev.samples++;
+        }
+      }
+      break;
+    }
+  }
+}
+
+/* ---- master ---- */
+
+static void bus_count(uint32_t tx_len, uint32_t rx_len) {
+  sim.i2c.jobs++;
+  sim.i2c.bytes += tx_len + rx_len;
+  sim.i2c.busy_us += xfer_us(tx_len, rx_len);
+}
+
+// adresna faza na prenosot, odreduva koga e sledniot nastan
+static void xfer_start(void) {
+  xfer_acked = slave_ack(xfer->sl_addr7bit);
+  if (xfer_acked) {
+    xfer_at = sim_now() + xfer_us(xfer->tx_length, xfer->rx_length);
+  } else {
+    sim.i2c.nacks++;
+    xfer_at = sim_now() + BYTE_US + STOP_US;
+  }
+}
+
+uint64_t sim_i2c_next(void) {
+  return xfer && !line_high ? xfer_at : UINT64_MAX;
+}
+
+void sim_i2c_fire(void) {
+  I2C_M_SETUP_Type * x = xfer;
+
+  if (!x || sim_now() < xfer_at)
+    return;
+  if (!xfer_acked) {
+    if (x->retransmissions_count < x->retransmissions_max) {
+      x->retransmissions_count++;
+      xfer_start();
+      return;
+    }
+    x->status = I2C_SETUP_STATUS_NOACKF;
+    bus_count(0, 0);
+  } else {
+    slave_xfer(x->sl_addr7bit, x->tx_data, x->tx_length, x->rx_data, x->rx_length);
+    x->tx_count = x->tx_length;
+    x->rx_count = x->rx_length;
+    x->status = I2C_SETUP_STATUS_DONE;
+    bus_count(x->tx_length, x->rx_length);
+  }
+  line_high = 1;
+  sim_irq(I2C2_IRQn);
+}
+
+int sim_i2c_line(void) {
+  return line_high;
+}
+
+int sim_i2c_blocking(uint8_t addr, const uint8_t * tx, uint32_t tx_len, uint8_t * rx, uint32_t rx_len) {
+  int ack;
+
+  if (xfer)
+    sim.i2c.conflicts++;
+  sim.i2c.blocking++;
+  blocking = 1;
+  ack = slave_ack(addr);
+  if (!ack) {
+    sim.i2c.nacks++;
+    sim_delay(BYTE_US + STOP_US);
+    bus_count(0, 0);
+    blocking = 0;
+    return -1;
+  }
+  sim_delay(xfer_us(tx_len, rx_len));
+  slave_xfer(addr, tx, tx_len, rx, rx_len);
+  bus_count(tx_len, rx_len);
+  blocking = 0;
+  return 0;
+}
+
+void sim_i2c_reset(void) {
+  memset( & sim_i2c2, 0, sizeof(sim_i2c2));
+  memset(pca_reg, 0, sizeof(pca_reg));
+  memset(light_reg, 0, sizeof(light_reg));
+  memset(acc_reg, 0, sizeof(acc_reg));
+  pca_ptr = 0;
+  acc_ptr = 0;
+  acc_last = 0;
+  eeprom_ptr = 0;
+  eeprom_ready = 0;
+  xfer = NULL;
+  line_high = 0;
+  complete = 0;
+  blocking = 0;
+  if (!sim.eeprom.write_cycle_us)
+    sim.eeprom.write_cycle_us = EEPROM_WRITE_US;
+  sim_eeprom();
+}
+
+void I2C_Init(LPC_I2C_TypeDef * I2Cx, uint32_t clockrate) {
+  if (I2Cx != LPC_I2C2 || clockrate != 100000)
+    sim_fault("only I2C2 at 100 kHz is simulated");
+}
+
+void I2C_Cmd(LPC_I2C_TypeDef * I2Cx, FunctionalState NewState) {
+  (void) I2Cx;
+  (void) NewState;
+}
+
+void I2C_IntCmd(LPC_I2C_TypeDef * I2Cx, Bool NewState) {
+  (void) I2Cx;
+  if (NewState) NVIC_EnableIRQ(I2C2_IRQn);
+  else NVIC_DisableIRQ(I2C2_IRQn);
+}
+
+Status I2C_MasterTransferData(LPC_I2C_TypeDef * I2Cx, I2C_M_SETUP_Type * TransferCfg, I2C_TRANSFER_OPT_Type Opt) {
+  (void) I2Cx;
+  if (xfer || blocking) {
+    sim.i2c.conflicts++;
+    return ERROR;
+  }
+  TransferCfg->tx_count = 0;
+  TransferCfg->rx_count = 0;
+  TransferCfg->retransmissions_count = 0;
+  TransferCfg->status = 0;
+  if (Opt == I2C_TRANSFER_POLLING) {
+    int r;
+    do {
+      r = sim_i2c_blocking(TransferCfg->sl_addr7bit, TransferCfg->tx_data, TransferCfg->tx_length,
+                           TransferCfg->rx_data, TransferCfg->rx_length);
+    } while (r && TransferCfg->retransmissions_count++ < TransferCfg->retransmissions_max);
+    TransferCfg->status = r ? I2C_SETUP_STATUS_NOACKF : I2C_SETUP_STATUS_DONE;
+    return r ? ERROR : SUCCESS;
+  }
+  xfer = TransferCfg;
+  complete = 0;
+  xfer_start();
+  return SUCCESS;
+}
+
+void I2C_MasterHandler(LPC_I2C_TypeDef * I2Cx) {
+  I2C_M_SETUP_Type * x = xfer;
+  (void) I2Cx;
+  if (!line_high || !x)
+    return;
+  line_high = 0;
+  xfer = NULL;
+  complete = 1;
+  if (x->callback)
+    x->callback();
+}
+
+uint32_t I2C_MasterTransferComplete(LPC_I2C_TypeDef * I2Cx) {
+  uint32_t r = complete;
+  (void) I2Cx;
+  complete = 0;
+  if (!r)
+    sim_spin();
+  return r;
+}
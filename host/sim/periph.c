@@ -0,0 +1,863 @@
+/*
+ * GPIO with the port 0/2 edge interrupts, the MAX6576 square wave on
+ * P0.2, ADC in burst mode, GPDMA, SSP1 with the OLED panel and the
+ * 7-segment display behind it, and the UART3 transmitter.
+ *
+ * DMA moves data the moment its peripheral asks: SSP1 pulls a byte
+ * whenever its transmit FIFO has room and pushes one for every byte
+ * it shifts in, the ADC hands over ADGDR after each conversion.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "lpc17xx_adc.h"
+#include "lpc17xx_gpdma.h"
+#include "lpc17xx_gpio.h"
+#include "lpc17xx_ssp.h"
+#include "lpc17xx_uart.h"
+#include "sim.h"
+
+#define PORTS 5
+#define PIN_EVENTS 256
+#define SSP_FIFO 8
+#define UART_FIFO UART_TX_FIFO_SIZE
+#define TEMP_PORT 0
+#define TEMP_PIN 2
+
+LPC_ADC_TypeDef sim_adc;
+LPC_SSP_TypeDef sim_ssp1;
+LPC_UART_TypeDef sim_uart3;
+LPC_GPDMA_TypeDef sim_gpdma;
+LPC_GPDMACH_TypeDef sim_gpdmach[8];
+
+/* ---- GPIO ---- */
+
+static uint32_t gpio_dir[PORTS];
+static uint32_t gpio_out[PORTS];
+static uint32_t gpio_ext[PORTS]; // nivo od nadvor, so pull-up
+static uint32_t int_en_r[PORTS];
+static uint32_t int_en_f[PORTS];
+static uint64_t temp_edge_at = UINT64_MAX; // posledniot prijaven rab na P0.2
+static uint32_t int_st_r[PORTS];
+static uint32_t int_st_f[PORTS];
+
+typedef struct {
+  uint64_t at;
+  uint8_t port;
+  uint8_t pin;
+  uint8_t level;
+} pin_event_t;
+
+static pin_event_t pin_events[PIN_EVENTS];
+static int pin_event_n;
+
+static uint32_t temp_period(void) {
+  return (uint32_t) (2731 + sim.temp);
+}
+
+// MAX6576: pravoagolen bran so perioda 10 us po K, prvata polovina e visoka
+static uint8_t temp_level(uint64_t t) {
+  return ((2 * t) / temp_period()) % 2 == 0;
+}
+
+// sledniot rab koj se ne e prijaven, moze da e i sega
+static uint64_t temp_next_edge(void) {
+  uint64_t k = (2 * sim_now()) / temp_period();
+  uint64_t at = (k * temp_period() + 1) / 2;
+  if (at < sim_now() || at == temp_edge_at)
+    at = ((k + 1) * temp_period() + 1) / 2;
+  return at;
+}
+
+static int temp_watched(void) {
+  uint32_t bit = 1u << TEMP_PIN;
+  return !(gpio_dir[TEMP_PORT] & bit) && ((int_en_r[TEMP_PORT] | int_en_f[TEMP_PORT]) & bit);
+}
+
+static uint8_t pin_level(uint8_t port, uint8_t pin) {
+  if (gpio_dir[port] & (1u << pin))
+    return (gpio_out[port] >> pin) & 1;
+  if (port == TEMP_PORT && pin == TEMP_PIN)
+    return temp_level(sim_now());
+  return (gpio_ext[port] >> pin) & 1;
+}
+
+uint8_t sim_pin(uint8_t port, uint8_t pin) {
+  return pin_level(port, pin);
+}
+
+static void pin_edge(uint8_t port, uint8_t pin, uint8_t level) {
+  uint32_t bit = 1u << pin;
+  if (port != 0 && port != 2)
+    return;
+  if (level && (int_en_r[port] & bit))
+    int_st_r[port] |= bit;
+  if (!level && (int_en_f[port] & bit))
+    int_st_f[port] |= bit;
+  if (sim_gpio_line())
+    sim_irq(EINT3_IRQn);
+}
+
+void sim_pin_at(uint64_t at, uint8_t port, uint8_t pin, uint8_t level) {
+  int i;
+  if (pin_event_n == PIN_EVENTS)
+    sim_fault("too many scheduled pin changes");
+  // podredeni po vreme, istovremenite po redosled na dodavanje
+  for (i = pin_event_n; i > 0 && pin_events[i - 1].at > at; i--)
+    pin_events[i] = pin_events[i - 1];
+  pin_events[i].at = at;
+  pin_events[i].port = port;
+  pin_events[i].pin = pin;
+  pin_events[i].level = level;
+  pin_event_n++;
+}
+
+// pritisok (nivo 0) so odbivanje na kontaktite pri pritiskanje i pustanje
+void sim_button(uint8_t port, uint8_t pin, uint64_t at, uint32_t hold_us, int bounces) {
+  for (int i = 0; i < bounces; i++) {
+    sim_pin_at(at + i * 400, port, pin, 0);
+    sim_pin_at(at + i * 400 + 200, port, pin, 1);
+    sim_pin_at(at + hold_us + i * 400, port, pin, 1);
+    sim_pin_at(at + hold_us + i * 400 + 200, port, pin, 0);
+  }
+  sim_pin_at(at + bounces * 400, port, pin, 0);
+  sim_pin_at(at + hold_us + bounces * 400, port, pin, 1);
+}
+
+int sim_gpio_line(void) {
+  return (int_st_r[0] | int_st_f[0] | int_st_r[2] | int_st_f[2]) != 0;
+}
+
+void GPIO_SetDir(uint8_t portNum, uint32_t bitValue, uint8_t dir) {
+  if (dir) gpio_dir[portNum] |= bitValue;
+  else gpio_dir[portNum] &= ~bitValue;
+}
+
+void GPIO_SetValue(uint8_t portNum, uint32_t bitValue) {
+  gpio_out[portNum] |= bitValue;
+}
+
+void GPIO_ClearValue(uint8_t portNum, uint32_t bitValue) {
+  gpio_out[portNum] &= ~bitValue;
+}
+
+uint32_t GPIO_ReadValue(uint8_t portNum) {
+  uint32_t v = (gpio_out[portNum] & gpio_dir[portNum]) | (gpio_ext[portNum] & ~gpio_dir[portNum]);
+  if (portNum == TEMP_PORT && !(gpio_dir[portNum] & (1u << TEMP_PIN))) {
+    v &= ~(1u << TEMP_PIN);
+    v |= (uint32_t) temp_level(sim_now()) << TEMP_PIN;
+  }
+  return v;
+}
+
+// kako vo Lib_MCU, registarot za dozvola se zapisuva, ne se dopolnuva
+void GPIO_IntCmd(uint8_t portNum, uint32_t bitValue, uint8_t edgeState) {
+  if (portNum != 0 && portNum != 2)
+    return;
+  if (edgeState == 0) int_en_r[portNum] = bitValue;
+  else if (edgeState == 1) int_en_f[portNum] = bitValue;
+}
+
+FunctionalState GPIO_GetIntStatus(uint8_t portNum, uint32_t pinNum, uint8_t edgeState) {
+  uint32_t st = edgeState ? int_st_f[portNum] : int_st_r[portNum];
+  return (st >> pinNum) & 1 ? ENABLE : DISABLE;
+}
+
+void GPIO_ClearInt(uint8_t portNum, uint32_t bitValue) {
+  int_st_r[portNum] &= ~bitValue;
+  int_st_f[portNum] &= ~bitValue;
+}
+
+/* ---- GPDMA ---- */
+
+#define CFG_SRC(c) (((c) >> 1) & 0x1f)
+#define CFG_DST(c) (((c) >> 6) & 0x1f)
+#define CFG_TYPE(c) (((c) >> 11) & 0x7)
+
+static void ssp_service(void);
+
+static uintptr_t conn_addr(uint32_t conn) {
+  switch (conn) {
+    case GPDMA_CONN_SSP1_Tx:
+    case GPDMA_CONN_SSP1_Rx: return (uintptr_t) & sim_ssp1.DR;
+    case GPDMA_CONN_ADC: return (uintptr_t) & sim_adc.ADGDR;
+    case GPDMA_CONN_UART3_Tx: return (uintptr_t) & sim_uart3.RBR_THR_DLL;
+  }
+  sim_fault("GPDMA connection %u is not simulated", conn);
+  return 0;
+}
+
+static uint32_t conn_width(uint32_t conn) {
+  return conn == GPDMA_CONN_ADC ? GPDMA_WIDTH_WORD : GPDMA_WIDTH_BYTE;
+}
+
+// kanal koj ceka na periferijata, so najmal broj (najvisok prioritet)
+static int dma_find(uint32_t conn, int to_periph) {
+  for (int ch = 0; ch < 8; ch++) {
+    uint32_t c = sim_gpdmach[ch].DMACCConfig;
+    if (!(c & GPDMA_DMACCxConfig_E))
+      continue;
+    if (to_periph && CFG_TYPE(c) == GPDMA_TRANSFERTYPE_M2P && CFG_DST(c) == conn)
+      return ch;
+    if (!to_periph && CFG_TYPE(c) == GPDMA_TRANSFERTYPE_P2M && CFG_SRC(c) == conn)
+      return ch;
+  }
+  return -1;
+}
+
+static uint32_t mem_read(uintptr_t a, uint32_t width) {
+  switch (width) {
+    case GPDMA_WIDTH_BYTE: return * (uint8_t *) a;
+    case GPDMA_WIDTH_HALFWORD: return * (uint16_t *) a;
+  }
+  return * (uint32_t *) a;
+}
+
+static void mem_write(uintptr_t a, uint32_t width, uint32_t v) {
+  switch (width) {
+    case GPDMA_WIDTH_BYTE: * (uint8_t *) a = v; break;
+    case GPDMA_WIDTH_HALFWORD: * (uint16_t *) a = v; break;
+    default: * (uint32_t *) a = v; break;
+  }
+}
+
+static void dma_complete(int ch) {
+  LPC_GPDMACH_TypeDef * c = & sim_gpdmach[ch];
+
+  if (c->DMACCControl & GPDMA_DMACCxControl_I) {
+    sim_gpdma.DMACRawIntTCStat |= 1u << ch;
+    if (c->DMACCConfig & (1u << 15))
+      sim_gpdma.DMACIntTCStat |= 1u << ch;
+  }
+  if (c->DMACCLLI) {
+    GPDMA_LLI_Type * l = (GPDMA_LLI_Type *) c->DMACCLLI;
+    c->DMACCSrcAddr = l->SrcAddr;
+    c->DMACCDestAddr = l->DstAddr;
+    c->DMACCLLI = l->NextLLI;
+    c->DMACCControl = l->Control;
+  } else {
+    c->DMACCConfig &= ~GPDMA_DMACCxConfig_E;
+    sim_gpdma.DMACEnbldChns &= ~(1u << ch);
+  }
+  sim_gpdma.DMACIntStat = sim_gpdma.DMACIntTCStat | sim_gpdma.DMACIntErrStat;
+  if (sim_dma_line())
+    sim_irq(DMA_IRQn);
+}
+
+// eden element na kanalot, vrednosta od/kon periferijata
+static uint32_t dma_step(int ch, uint32_t v) {
+  LPC_GPDMACH_TypeDef * c = & sim_gpdmach[ch];
+  uint32_t sw = (c->DMACCControl >> 18) & 7;
+  uint32_t dw = (c->DMACCControl >> 21) & 7;
+  uint32_t size = c->DMACCControl & 0xfff;
+
+  if (CFG_TYPE(c->DMACCConfig) == GPDMA_TRANSFERTYPE_M2P)
+    v = mem_read(c->DMACCSrcAddr, sw);
+  else
+    mem_write(c->DMACCDestAddr, dw, v);
+  if (c->DMACCControl & GPDMA_DMACCxControl_SI)
+    c->DMACCSrcAddr += 1u << sw;
+  if (c->DMACCControl & GPDMA_DMACCxControl_DI)
+    c->DMACCDestAddr += 1u << dw;
+  c->DMACCControl = (c->DMACCControl & ~0xfffu) | (size - 1);
+  if (size - 1 == 0)
+    dma_complete(ch);
+  return v;
+}
+
+int sim_dma_line(void) {
+  return (sim_gpdma.DMACIntTCStat | sim_gpdma.DMACIntErrStat) != 0;
+}
+
+void GPDMA_Init(void) {
+  memset( & sim_gpdma, 0, sizeof(sim_gpdma));
+  memset(sim_gpdmach, 0, sizeof(sim_gpdmach));
+}
+
+Status GPDMA_Setup(GPDMA_Channel_CFG_Type * cfg) {
+  LPC_GPDMACH_TypeDef * c;
+  uint32_t ctl, conn, w;
+
+  if (cfg->ChannelNum > 7)
+    return ERROR;
+  c = & sim_gpdmach[cfg->ChannelNum];
+  if (c->DMACCConfig & GPDMA_DMACCxConfig_E)
+    return ERROR;
+
+  sim_gpdma.DMACIntTCStat &= ~(1u << cfg->ChannelNum);
+  sim_gpdma.DMACRawIntTCStat &= ~(1u << cfg->ChannelNum);
+  sim_gpdma.DMACIntErrStat &= ~(1u << cfg->ChannelNum);
+  sim_gpdma.DMACIntStat = sim_gpdma.DMACIntTCStat | sim_gpdma.DMACIntErrStat;
+
+  ctl = GPDMA_DMACCxControl_TransferSize(cfg->TransferSize) | GPDMA_DMACCxControl_I;
+  switch (cfg->TransferType) {
+    case GPDMA_TRANSFERTYPE_M2P:
+      conn = cfg->DstConn;
+      w = conn_width(conn);
+      c->DMACCSrcAddr = cfg->SrcMemAddr;
+      c->DMACCDestAddr = conn_addr(conn);
+      ctl |= GPDMA_DMACCxControl_SWidth(w) | GPDMA_DMACCxControl_DWidth(w) | GPDMA_DMACCxControl_SI;
+      c->DMACCConfig = (conn << 6);
+      break;
+    case GPDMA_TRANSFERTYPE_P2M:
+      conn = cfg->SrcConn;
+      w = conn_width(conn);
+      c->DMACCSrcAddr = conn_addr(conn);
+      c->DMACCDestAddr = cfg->DstMemAddr;
+      ctl |= GPDMA_DMACCxControl_SWidth(w) | GPDMA_DMACCxControl_DWidth(w) | GPDMA_DMACCxControl_DI;
+      c->DMACCConfig = (conn << 1);
+      break;
+    default:
+      sim_fault("GPDMA transfer type %u is not simulated", cfg->TransferType);
+      return ERROR;
+  }
+  c->DMACCControl = ctl;
+  c->DMACCLLI = cfg->DMALLI;
+  c->DMACCConfig |= (cfg->TransferType << 11) | (1u << 14) | (1u << 15);
+  return SUCCESS;
+}
+
+IntStatus GPDMA_IntGetStatus(GPDMA_Status_Type type, uint8_t channel) {
+  uint32_t r = 0;
+  switch (type) {
+    case GPDMA_STAT_INT: r = sim_gpdma.DMACIntStat; break;
+    case GPDMA_STAT_INTTC: r = sim_gpdma.DMACIntTCStat; break;
+    case GPDMA_STAT_INTERR: r = sim_gpdma.DMACIntErrStat; break;
+    case GPDMA_STAT_RAWINTTC: r = sim_gpdma.DMACRawIntTCStat; break;
+    case GPDMA_STAT_RAWINTERR: r = sim_gpdma.DMACRawIntErrStat; break;
+    case GPDMA_STAT_ENABLED_CH: r = sim_gpdma.DMACEnbldChns; break;
+  }
+  return (r >> channel) & 1 ? SET : RESET;
+}
+
+void GPDMA_ClearIntPending(GPDMA_StateClear_Type type, uint8_t channel) {
+  if (type == GPDMA_STATCLR_INTTC) {
+    sim_gpdma.DMACIntTCStat &= ~(1u << channel);
+    sim_gpdma.DMACRawIntTCStat &= ~(1u << channel);
+  } else {
+    sim_gpdma.DMACIntErrStat &= ~(1u << channel);
+    sim_gpdma.DMACRawIntErrStat &= ~(1u << channel);
+  }
+  sim_gpdma.DMACIntStat = sim_gpdma.DMACIntTCStat | sim_gpdma.DMACIntErrStat;
+}
+
+void GPDMA_ChannelCmd(uint8_t channelNum, FunctionalState NewState) {
+  LPC_GPDMACH_TypeDef * c = & sim_gpdmach[channelNum];
+  if (NewState == ENABLE) {
+    c->DMACCConfig |= GPDMA_DMACCxConfig_E;
+    sim_gpdma.DMACEnbldChns |= 1u << channelNum;
+    ssp_service();
+  } else {
+    c->DMACCConfig &= ~GPDMA_DMACCxConfig_E;
+    sim_gpdma.DMACEnbldChns &= ~(1u << channelNum);
+  }
+}
+
+/* ---- ADC ---- */
+
+static uint32_t adc_us;
+static uint64_t adc_next;
+static int adc_burst;
+static int adc_single;
+static int adc_chan; // sledniot kanal vo burst
+
+static volatile uint32_t * adc_dr(int ch) {
+  return & sim_adc.ADDR0 + ch;
+}
+
+static void adc_convert(void) {
+  uint32_t sel = sim_adc.ADCR & 0xff;
+  uint32_t v, dr;
+  int ch;
+
+  if (!sel)
+    return;
+  while (!(sel & (1u << adc_chan)))
+    adc_chan = (adc_chan + 1) & 7;
+  ch = adc_chan;
+  adc_chan = (adc_chan + 1) & 7;
+
+  v = ch == 0 ? (sim.pot_fn ? sim.pot_fn(sim_now()) : sim.pot) : 0;
+  v &= 0xfff;
+  sim.adc.conversions++;
+
+  dr = ADC_DR_DONE_FLAG | (v << 4);
+  if ( * adc_dr(ch) & ADC_DR_DONE_FLAG)
+    dr |= ADC_DR_OVERRUN_FLAG;
+  * adc_dr(ch) = dr;
+  dr = ADC_GDR_DONE_FLAG | ((uint32_t) ch << 24) | (v << 4);
+  if (sim_adc.ADGDR & ADC_GDR_DONE_FLAG)
+    dr |= ADC_GDR_OVERRUN_FLAG;
+  sim_adc.ADGDR = dr;
+  sim_adc.ADSTAT |= 1u << ch;
+
+  // DMA zahtev ide so bitot za prekin na kanalot
+  if (sim_adc.ADINTEN & (1u << ch)) {
+    int dch = dma_find(GPDMA_CONN_ADC, 0);
+    if (dch >= 0) {
+      dma_step(dch, sim_adc.ADGDR);
+      sim_adc.ADGDR &= ~(ADC_GDR_DONE_FLAG | ADC_GDR_OVERRUN_FLAG);
+      sim.adc.dma_words++;
+    }
+  }
+  if (sim_adc_line())
+    sim_irq(ADC_IRQn);
+}
+
+int sim_adc_line(void) {
+  for (int ch = 0; ch < 8; ch++)
+    if ((sim_adc.ADINTEN & (1u << ch)) && ( * adc_dr(ch) & ADC_DR_DONE_FLAG))
+      return 1;
+  return (sim_adc.ADINTEN & 0x100) && (sim_adc.ADGDR & ADC_GDR_DONE_FLAG);
+}
+
+void ADC_Init(LPC_ADC_TypeDef * ADCx, uint32_t rate) {
+  (void) ADCx;
+  memset( & sim_adc, 0, sizeof(sim_adc));
+  sim_adc.ADCR = 1u << 21; // PDN
+  sim_adc.ADINTEN = 0x100;
+  adc_us = 1000000 / rate;
+  adc_burst = 0;
+  adc_single = 0;
+  adc_chan = 0;
+}
+
+void ADC_BurstCmd(LPC_ADC_TypeDef * ADCx, FunctionalState NewState) {
+  (void) ADCx;
+  adc_burst = NewState == ENABLE;
+  if (adc_burst) {
+    sim_adc.ADCR |= 1u << 16;
+    adc_next = sim_now() + adc_us;
+  } else {
+    sim_adc.ADCR &= ~(1u << 16);
+  }
+}
+
+void ADC_StartCmd(LPC_ADC_TypeDef * ADCx, uint8_t start_mode) {
+  (void) ADCx;
+  if (start_mode == ADC_START_NOW) {
+    adc_single = 1;
+    adc_next = sim_now() + adc_us;
+  }
+}
+
+void ADC_IntConfig(LPC_ADC_TypeDef * ADCx, ADC_TYPE_INT_OPT IntType, FunctionalState NewState) {
+  (void) ADCx;
+  sim_adc.ADINTEN &= ~(1u << IntType);
+  if (NewState == ENABLE)
+    sim_adc.ADINTEN |= 1u << IntType;
+}
+
+void ADC_ChannelCmd(LPC_ADC_TypeDef * ADCx, uint8_t Channel, FunctionalState NewState) {
+  (void) ADCx;
+  if (NewState == ENABLE) sim_adc.ADCR |= 1u << Channel;
+  else sim_adc.ADCR &= ~(1u << Channel);
+}
+
+// citanjeto na ADDRn gi brise DONE i OVERRUN
+uint16_t ADC_ChannelGetData(LPC_ADC_TypeDef * ADCx, uint8_t channel) {
+  uint32_t dr = * adc_dr(channel);
+  (void) ADCx;
+  * adc_dr(channel) = dr & ~(ADC_DR_DONE_FLAG | ADC_DR_OVERRUN_FLAG);
+  sim_adc.ADSTAT &= ~(1u << channel);
+  return ADC_DR_RESULT(dr);
+}
+
+FlagStatus ADC_ChannelGetStatus(LPC_ADC_TypeDef * ADCx, uint8_t channel, uint32_t StatusType) {
+  uint32_t flag = StatusType == ADC_DATA_DONE ? ADC_DR_DONE_FLAG : ADC_DR_OVERRUN_FLAG;
+  (void) ADCx;
+  if ( * adc_dr(channel) & flag)
+    return SET;
+  sim_spin();
+  return RESET;
+}
+
+uint32_t ADC_GlobalGetData(LPC_ADC_TypeDef * ADCx) {
+  uint32_t dr = sim_adc.ADGDR;
+  (void) ADCx;
+  sim_adc.ADGDR = dr & ~(ADC_GDR_DONE_FLAG | ADC_GDR_OVERRUN_FLAG);
+  return dr;
+}
+
+/* ---- SSP1, OLED panel, 7-segment ---- */
+
+static uint32_t ssp_us;
+static uint8_t tx_fifo[SSP_FIFO];
+static int tx_n;
+static uint8_t rx_fifo[SSP_FIFO];
+static int rx_n;
+static int shifting;
+static uint8_t shift_byte;
+static uint8_t shift_dc;
+static uint64_t shift_end;
+
+static uint8_t panel_page;
+static uint8_t panel_col;
+
+uint32_t sim_ssp_byte_us(void) {
+  return ssp_us;
+}
+
+static void panel_byte(uint8_t b, uint8_t dc) {
+  sim.oled.bytes++;
+  if (dc) {
+    sim.oled.data_bytes++;
+    sim.oled.ram[panel_page][panel_col] = b;
+    panel_col = (panel_col + 1) % SIM_OLED_COLUMNS;
+    return;
+  }
+  sim.oled.cmd_bytes++;
+  if ((b & 0xf8) == 0xb0)
+    panel_page = b & 7;
+  else if ((b & 0xf0) == 0x00)
+    panel_col = (panel_col & 0xf0) | (b & 0x0f);
+  else if ((b & 0xf0) == 0x10)
+    panel_col = ((b & 0x0f) << 4) | (panel_col & 0x0f);
+}
+
+int sim_oled_pixel(int x, int y) {
+  return (sim.oled.ram[y / 8][x + SIM_OLED_X_OFFSET] >> (y % 8)) & 1;
+}
+
+static void ssp_status(void) {
+  uint32_t sr = 0;
+  if (!tx_n) sr |= SSP_STAT_TXFIFO_EMPTY;
+  if (tx_n < SSP_FIFO) sr |= SSP_STAT_TXFIFO_NOTFULL;
+  if (rx_n) sr |= SSP_STAT_RXFIFO_NOTEMPTY;
+  if (rx_n == SSP_FIFO) sr |= SSP_STAT_RXFIFO_FULL;
+  if (shifting || tx_n) sr |= SSP_STAT_BUSY;
+  sim_ssp1.SR = sr;
+}
+
+static void ssp_shift(void) {
+  shift_byte = tx_fifo[0];
+  memmove(tx_fifo, tx_fifo + 1, --tx_n);
+  shift_dc = pin_level(2, 7);
+  shift_end = sim_now() + ssp_us;
+  shifting = 1;
+}
+
+// DMA dopolnuva TX FIFO i go prazni RX FIFO, potoa se prodolzuva so prakjanje
+static void ssp_service(void) {
+  int ch;
+  if (sim_ssp1.DMACR & SSP_DMA_TX)
+    while (tx_n < SSP_FIFO && (ch = dma_find(GPDMA_CONN_SSP1_Tx, 1)) >= 0)
+      tx_fifo[tx_n++] = dma_step(ch, 0);
+  if (sim_ssp1.DMACR & SSP_DMA_RX)
+    while (rx_n && (ch = dma_find(GPDMA_CONN_SSP1_Rx, 0)) >= 0) {
+      dma_step(ch, rx_fifo[0]);
+      memmove(rx_fifo, rx_fifo + 1, --rx_n);
+    }
+  if (!shifting && tx_n)
+    ssp_shift();
+  ssp_status();
+}
+
+static void ssp_byte_done(void) {
+  shifting = 0;
+  sim.ssp.bytes++;
+  if (!(gpio_out[0] & (1u << 6))) {
+    if (pin_level(2, 7) != shift_dc)
+      sim.oled.dc_glitches++;
+    panel_byte(shift_byte, shift_dc);
+  }
+  if (!(gpio_out[2] & (1u << 2)))
+    sim.seg.writes++;
+  if (rx_n < SSP_FIFO)
+    rx_fifo[rx_n++] = 0xff;
+  else
+    sim.ssp.overruns++;
+  ssp_service();
+}
+
+void sim_ssp_send(uint8_t b) {
+  if (tx_n < SSP_FIFO)
+    tx_fifo[tx_n++] = b;
+  ssp_service();
+}
+
+void SSP_ConfigStructInit(SSP_CFG_Type * SSP_InitStruct) {
+  SSP_InitStruct->CPHA = SSP_CPHA_FIRST;
+  SSP_InitStruct->CPOL = SSP_CPOL_HI;
+  SSP_InitStruct->ClockRate = 1000000;
+  SSP_InitStruct->Databit = SSP_DATABIT_8;
+  SSP_InitStruct->Mode = SSP_MASTER_MODE;
+  SSP_InitStruct->FrameFormat = SSP_FRAME_SPI;
+}
+
+void SSP_Init(LPC_SSP_TypeDef * SSPx, SSP_CFG_Type * SSP_ConfigStruct) {
+  if (SSPx != LPC_SSP1)
+    sim_fault("only SSP1 is simulated");
+  ssp_us = (8000000 + SSP_ConfigStruct->ClockRate - 1) / SSP_ConfigStruct->ClockRate;
+}
+
+void SSP_Cmd(LPC_SSP_TypeDef * SSPx, FunctionalState NewState) {
+  if (NewState == ENABLE) SSPx->CR1 |= 2;
+  else SSPx->CR1 &= ~2u;
+}
+
+void SSP_SendData(LPC_SSP_TypeDef * SSPx, uint16_t Data) {
+  (void) SSPx;
+  sim_ssp_send((uint8_t) Data);
+}
+
+uint16_t SSP_ReceiveData(LPC_SSP_TypeDef * SSPx) {
+  uint8_t b = 0;
+  (void) SSPx;
+  if (rx_n) {
+    b = rx_fifo[0];
+    memmove(rx_fifo, rx_fifo + 1, --rx_n);
+  }
+  ssp_status();
+  return b;
+}
+
+FlagStatus SSP_GetStatus(LPC_SSP_TypeDef * SSPx, uint32_t FlagType) {
+  (void) SSPx;
+  sim_spin();
+  ssp_status();
+  return sim_ssp1.SR & FlagType ? SET : RESET;
+}
+
+// polled prenos kako vo Lib_MCU: prvo go prazni RX FIFO, pa bajt po bajt
+int32_t SSP_ReadWrite(LPC_SSP_TypeDef * SSPx, SSP_DATA_SETUP_Type * dataCfg, SSP_TRANSFER_Type xfType) {
+  uint8_t * tx = dataCfg->tx_data;
+  uint8_t * rx = dataCfg->rx_data;
+
+  if (xfType != SSP_TRANSFER_POLLING)
+    sim_fault("only polled SSP transfers are simulated");
+  if (dma_find(GPDMA_CONN_SSP1_Tx, 1) >= 0 || dma_find(GPDMA_CONN_SSP1_Rx, 0) >= 0)
+    sim.ssp.conflicts++;
+
+  while (SSP_GetStatus(SSPx, SSP_STAT_RXFIFO_NOTEMPTY) == SET)
+    SSP_ReceiveData(SSPx);
+
+  dataCfg->tx_cnt = 0;
+  dataCfg->rx_cnt = 0;
+  while (dataCfg->tx_cnt < dataCfg->length || dataCfg->rx_cnt < dataCfg->length) {
+    if (dataCfg->tx_cnt < dataCfg->length && SSP_GetStatus(SSPx, SSP_STAT_TXFIFO_NOTFULL) == SET) {
+      SSP_SendData(SSPx, tx ? tx[dataCfg->tx_cnt] : 0xff);
+      dataCfg->tx_cnt++;
+    }
+    while (SSP_GetStatus(SSPx, SSP_STAT_RXFIFO_NOTEMPTY) == SET && dataCfg->rx_cnt < dataCfg->length) {
+      uint16_t b = SSP_ReceiveData(SSPx);
+      if (rx)
+        rx[dataCfg->rx_cnt] = (uint8_t) b;
+      dataCfg->rx_cnt++;
+    }
+  }
+  return dataCfg->tx_cnt;
+}
+
+void SSP_DMACmd(LPC_SSP_TypeDef * SSPx, uint32_t DMAMode, FunctionalState NewState) {
+  if (NewState == ENABLE) SSPx->DMACR |= DMAMode;
+  else SSPx->DMACR &= ~DMAMode;
+  ssp_service();
+}
+
+/* ---- UART3 ---- */
+
+static uint32_t uart_us;
+static uint8_t uart_fifo[UART_FIFO + 1]; // FIFO zad shift registarot
+static int uart_n;
+static int uart_shifting;
+static uint64_t uart_end;
+static int thre_pending;
+
+static void uart_out(uint8_t b) {
+  if (sim.uart.len == sim.uart.cap) {
+    sim.uart.cap = sim.uart.cap ? 2 * sim.uart.cap : 4096;
+    sim.uart.out = realloc(sim.uart.out, sim.uart.cap);
+    if (!sim.uart.out)
+      sim_fault("uart capture");
+  }
+  sim.uart.out[sim.uart.len++] = b;
+}
+
+static void uart_thre(void) {
+  if (sim_uart3.IER_DLM & 2) {
+    thre_pending = 1;
+    sim_irq(UART3_IRQn);
+  }
+}
+
+// uart_fifo[0] e bajtot vo shift registarot
+static void uart_shift(void) {
+  uart_end = sim_now() + uart_us;
+  uart_shifting = 1;
+}
+
+static void uart_byte_done(void) {
+  uart_out(uart_fifo[0]);
+  memmove(uart_fifo, uart_fifo + 1, --uart_n);
+  uart_shifting = 0;
+  if (uart_n) {
+    uart_shift();
+    if (uart_n == 1)
+      uart_thre();
+  }
+}
+
+int sim_uart_line(void) {
+  return thre_pending && (sim_uart3.IER_DLM & 2);
+}
+
+void UART_ConfigStructInit(UART_CFG_Type * UART_InitStruct) {
+  UART_InitStruct->Baud_rate = 9600;
+  UART_InitStruct->Databits = UART_DATABIT_8;
+  UART_InitStruct->Parity = UART_PARITY_NONE;
+  UART_InitStruct->Stopbits = UART_STOPBIT_1;
+}
+
+void UART_Init(LPC_UART_TypeDef * UARTx, UART_CFG_Type * UART_ConfigStruct) {
+  if (UARTx != LPC_UART3)
+    sim_fault("only UART3 is simulated");
+  // start, 8 bita, stop
+  uart_us = (10000000 + UART_ConfigStruct->Baud_rate - 1) / UART_ConfigStruct->Baud_rate;
+}
+
+void UART_FIFOConfigStructInit(UART_FIFO_CFG_Type * UART_FIFOInitStruct) {
+  UART_FIFOInitStruct->FIFO_DMAMode = DISABLE;
+  UART_FIFOInitStruct->FIFO_Level = UART_FIFO_TRGLEV0;
+  UART_FIFOInitStruct->FIFO_ResetRxBuf = ENABLE;
+  UART_FIFOInitStruct->FIFO_ResetTxBuf = ENABLE;
+}
+
+void UART_FIFOConfig(LPC_UART_TypeDef * UARTx, UART_FIFO_CFG_Type * FIFOCfg) {
+  (void) UARTx;
+  (void) FIFOCfg;
+}
+
+void UART_TxCmd(LPC_UART_TypeDef * UARTx, FunctionalState NewState) {
+  (void) UARTx;
+  (void) NewState;
+}
+
+void UART_IntConfig(LPC_UART_TypeDef * UARTx, UART_INT_Type UARTIntCfg, FunctionalState NewState) {
+  uint32_t bit = 1u << UARTIntCfg;
+  if (NewState == ENABLE) {
+    UARTx->IER_DLM |= bit;
+    // kako kaj 16550, prazen FIFO dava THRE vednas po dozvolata
+    if (UARTIntCfg == UART_INTCFG_THRE && uart_n == 0)
+      uart_thre();
+  } else {
+    UARTx->IER_DLM &= ~bit;
+  }
+}
+
+void UART_SendByte(LPC_UART_TypeDef * UARTx, uint8_t Data) {
+  (void) UARTx;
+  if (uart_n - uart_shifting == UART_FIFO) {
+    sim.uart.overruns++;
+    return;
+  }
+  uart_fifo[uart_n++] = Data;
+  thre_pending = 0;
+  // THR se prazni vednas ako shift registarot e sloboden
+  if (!uart_shifting) {
+    uart_shift();
+    uart_thre();
+  }
+}
+
+// citanjeto na IIR go brise THRE
+uint32_t UART_GetIntId(LPC_UART_TypeDef * UARTx) {
+  (void) UARTx;
+  if (thre_pending) {
+    thre_pending = 0;
+    return UART_IIR_INTID_THRE;
+  }
+  return UART_IIR_INTSTAT_PEND;
+}
+
+uint8_t UART_GetLineStatus(LPC_UART_TypeDef * UARTx) {
+  uint8_t lsr = 0;
+  (void) UARTx;
+  if (uart_n <= (uart_shifting ? 1 : 0)) lsr |= UART_LSR_THRE;
+  if (!uart_n) lsr |= UART_LSR_TEMT;
+  if (!(lsr & UART_LSR_THRE))
+    sim_spin();
+  return lsr;
+}
+
+/* ---- events ---- */
+
+uint64_t sim_periph_next(void) {
+  uint64_t next = UINT64_MAX;
+  if (pin_event_n)
+    next = pin_events[0].at;
+  if (temp_watched() && temp_next_edge() < next)
+    next = temp_next_edge();
+  if ((adc_burst || adc_single) && adc_next < next)
+    next = adc_next;
+  if (shifting && shift_end < next)
+    next = shift_end;
+  if (uart_shifting && uart_end < next)
+    next = uart_end;
+  return next;
+}
+
+void sim_periph_fire(void) {
+  uint64_t now = sim_now();
+
+  while (pin_event_n && pin_events[0].at <= now) {
+    pin_event_t e = pin_events[0];
+    uint8_t old = pin_level(e.port, e.pin);
+    memmove(pin_events, pin_events + 1, --pin_event_n * sizeof(pin_events[0]));
+    if (e.level) gpio_ext[e.port] |= 1u << e.pin;
+    else gpio_ext[e.port] &= ~(1u << e.pin);
+    if (pin_level(e.port, e.pin) != old && !(gpio_dir[e.port] & (1u << e.pin)))
+      pin_edge(e.port, e.pin, e.level);
+  }
+  // rabot na branot e tocno vo ova vreme
+  if (temp_watched() && temp_next_edge() == now) {
+    temp_edge_at = now;
+    pin_edge(TEMP_PORT, TEMP_PIN, temp_level(now));
+  }
+  if ((adc_burst || adc_single) && adc_next <= now) {
+    adc_convert();
+    if (adc_burst) {
+      adc_next += adc_us;
+    } else {
+      adc_single = 0;
+    }
+  }
+  if (shifting && shift_end <= now)
+    ssp_byte_done();
+  if (uart_shifting && uart_end <= now)
+    uart_byte_done();
+}
+
+void sim_periph_reset(void) {
+  memset(gpio_dir, 0, sizeof(gpio_dir));
+  memset(gpio_out, 0, sizeof(gpio_out));
+  memset(gpio_ext, 0xff, sizeof(gpio_ext));
+  memset(int_en_r, 0, sizeof(int_en_r));
+  memset(int_en_f, 0, sizeof(int_en_f));
+  temp_edge_at = UINT64_MAX;
+  memset(int_st_r, 0, sizeof(int_st_r));
+  memset(int_st_f, 0, sizeof(int_st_f));
+  pin_event_n = 0;
+
+  memset( & sim_adc, 0, sizeof(sim_adc));
+  sim_adc.ADINTEN = 0x100;
+  adc_burst = 0;
+  adc_single = 0;
+
+  GPDMA_Init();
+
+  memset( & sim_ssp1, 0, sizeof(sim_ssp1));
+  ssp_us = 8;
+  tx_n = 0;
+  rx_n = 0;
+  shifting = 0;
+  panel_page = 0;
+  panel_col = 0;
+
+  memset( & sim_uart3, 0, sizeof(sim_uart3));
+  uart_us = 87;
+  uart_n = 0;
+  uart_shifting = 0;
+  thre_pending = 0;
+}
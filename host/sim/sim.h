@@ -0,0 +1,165 @@
+/*
+ * Simulated LPCXpresso base board for the host build.
+ *
+ * Time is virtual, in microseconds, and only moves while the firmware
+ * sleeps in __WFI() or waits in a blocking driver. Every peripheral
+ * schedules its next event on this clock and raises its interrupt
+ * through a simulated NVIC, which runs the firmware's handlers with
+ * the same masking rules as the Cortex-M3: nothing preempts a handler,
+ * PRIMASK holds interrupts back, and WFI wakes on a pending interrupt
+ * even with PRIMASK set.
+ *
+ * Tests drive the inputs (temperature, light, potentiometer,
+ * accelerometer, buttons) through sim and read the device side back:
+ * EEPROM contents and wear, bus time, panel memory, UART bytes.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#define SIM_EEPROM_SIZE 16384
+#define SIM_EEPROM_PAGE 64
+#define SIM_EEPROM_PAGES (SIM_EEPROM_SIZE / SIM_EEPROM_PAGE)
+#define SIM_OLED_COLUMNS 132
+#define SIM_OLED_X_OFFSET 18
+#define SIM_OLED_PAGES 8
+#define SIM_PINS_MAX 64
+
+typedef struct {
+  // ulezi, mozat da se menuvaat vo bilo koe vreme
+  int32_t temp; // 0.1 C
+  uint32_t lux;
+  uint16_t pot; // 12-bitna vrednost na AD0.0
+  uint16_t (*pot_fn)(uint64_t us); // ako e postaven, namesto pot
+  int8_t acc[3]; // X, Y, Z vo 1/64 g
+  int8_t acc_amp; // vibracija po Z
+  uint16_t acc_hz;
+  uint32_t cpu_scale; // 0 = kodot ne trosi vreme, inaku ns virtuelno za 1 ns na host
+
+  struct {
+    uint32_t jobs;
+    uint32_t bytes;
+    uint32_t nacks;
+    uint64_t busy_us;
+    uint32_t blocking; // transakcii od blokirackite drajveri
+    uint32_t conflicts; // transakcija zapocnata dodeka magistralata e zafatena
+  } i2c;
+
+  struct {
+    uint32_t write_cycle_us;
+    uint32_t page_writes;
+    uint32_t bytes_written;
+    uint32_t reads;
+    uint32_t busy_nacks; // adresirana za vreme na ciklusot za zapis
+    uint64_t busy_us; // vkupno vreme vo ciklus za zapis
+    uint16_t wear[SIM_EEPROM_PAGES];
+    uint32_t cut_at; // struja se isklucuva na ovoj zapis (1 = prviot), 0 = nikogas
+    uint8_t cut_bytes; // kolku bajti od toj zapis stignuvaat
+    void (*power_off)(void); // po isklucuvanjeto, inaku _exit(0)
+  } eeprom;
+
+  struct {
+    uint32_t writes;
+    uint16_t leds; // svetnati LED
+  } pca;
+
+  struct {
+    uint32_t reads;
+    uint32_t samples; // procitani primeroci
+    uint8_t mctl;
+    uint8_t ctl1;
+  } acc_dev;
+
+  struct {
+    uint32_t conversions;
+    uint32_t dma_words;
+  } adc;
+
+  struct {
+    uint32_t bytes; // bajti na panelot
+    uint32_t data_bytes;
+    uint32_t cmd_bytes;
+    uint8_t ram[SIM_OLED_PAGES][SIM_OLED_COLUMNS];
+    uint32_t dc_glitches; // D/C se smenil dodeka bajtot se prakjal
+  } oled;
+
+  struct {
+    uint32_t bytes;
+    uint32_t conflicts; // polled prenos dodeka DMA e aktiven
+    uint32_t overruns; // RX FIFO bil poln
+  } ssp;
+
+  struct {
+    uint32_t writes;
+    uint8_t ch;
+  } seg;
+
+  struct {
+    uint8_t * out; // se sto izleglo na TXD3
+    uint32_t len;
+    uint32_t cap;
+    uint32_t overruns;
+  } uart;
+
+  struct {
+    uint32_t count[32]; // po IRQn + 1, 0 = SysTick
+    uint32_t wfi;
+    uint64_t sleep_us; // vo WFI
+    uint64_t busy_us; // vo blokirackite drajveri
+    uint64_t spin_us; // vo polling na statusni registri
+    uint64_t cpu_us; // kod naplaten preku cpu_scale
+    uint32_t storms; // prekin koj ostanuva aktiven i po obrabotkata
+  } core;
+} sim_t;
+
+extern sim_t sim;
+
+// power-on reset na plocata, EEPROM ja zadrzuva sodrzinata
+void sim_reset(void);
+void sim_eeprom_erase(void);
+uint8_t * sim_eeprom(void);
+
+uint64_t sim_now(void);
+void sim_delay(uint32_t us);
+void sim_spin(void);
+void sim_fault(const char * fmt, ...);
+
+// nivo na pin vo dadeno vreme, rabovite okinuvaat GPIO prekini
+void sim_pin_at(uint64_t at, uint8_t port, uint8_t pin, uint8_t level);
+void sim_button(uint8_t port, uint8_t pin, uint64_t at, uint32_t hold_us, int bounces);
+uint8_t sim_pin(uint8_t port, uint8_t pin);
+int sim_oled_pixel(int x, int y);
+
+/*
+ * Between the simulator modules. Each device reports the time of its
+ * next event (UINT64_MAX for none), handles it when the clock gets
+ * there, and tells the NVIC whether its interrupt line is still high.
+ */
+void sim_irq(int irqn);
+uint32_t sim_ssp_byte_us(void);
+
+void sim_core_reset(void);
+void sim_periph_reset(void);
+void sim_i2c_reset(void);
+void sim_board_reset(void);
+
+uint64_t sim_timers_next(void);
+void sim_timers_fire(void);
+void sim_timers_elapse(uint64_t us);
+int sim_timer_line(int n);
+
+uint64_t sim_i2c_next(void);
+void sim_i2c_fire(void);
+int sim_i2c_line(void);
+int sim_i2c_blocking(uint8_t addr, const uint8_t * tx, uint32_t tx_len, uint8_t * rx, uint32_t rx_len);
+
+uint64_t sim_periph_next(void);
+void sim_periph_fire(void);
+int sim_adc_line(void);
+int sim_dma_line(void);
+int sim_uart_line(void);
+int sim_gpio_line(void);
+void sim_ssp_send(uint8_t b);
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * The potentiometer is sampled in the background: GPDMA copies every
+ * burst conversion into adc_ring[] and interrupts only once per half
+ * ring, the ADC interrupt never runs and nothing polls for a result.
+ */
+#include "fw.h"
+#include "check.h"
+
+static uint16_t pot_alternate(uint64_t us) {
+  return (us / (1000000 / ADC_SAMPLE_RATE)) & 1 ? 1100 : 1000;
+}
+
+int main(void) {
+  uint32_t conv, blocks, dma_irqs, expect;
+  uint64_t t0;
+
+  fw_boot();
+  fw_run(100);
+  conv = sim.adc.conversions;
+  blocks = adc_blocks;
+  dma_irqs = sim.core.count[DMA_IRQn + 1];
+  t0 = sim_now();
+  fw_run(1000);
+  expect = (sim_now() - t0) * ADC_SAMPLE_RATE / 1000000;
+  conv = sim.adc.conversions - conv;
+  blocks = adc_blocks - blocks;
+  dma_irqs = sim.core.count[DMA_IRQn + 1] - dma_irqs;
+
+  CHECK_RANGE(conv, expect - 1, expect + 1);
+  CHECK_EQ(sim.adc.dma_words, sim.adc.conversions);
+  CHECK_RANGE(blocks, conv / (ADC_RING_SIZE / 2) - 1, conv / (ADC_RING_SIZE / 2) + 1);
+  CHECK(dma_irqs >= blocks);
+  CHECK_EQ(sim.core.count[ADC_IRQn + 1], 0);
+  CHECK_EQ(sim.core.storms, 0);
+  CHECK_EQ(LPC_ADC->ADINTEN & (1 << ADC_ADGINTEN), 0);
+
+  sim.pot = 3000;
+  fw_run(20);
+  CHECK_EQ(read_potentiometer(), 3000);
+
+  // prosekot gi izramnuva sosednite konverzii
+  sim.pot_fn = pot_alternate;
+  fw_run(20);
+  CHECK_EQ(read_potentiometer(), 1050);
+
+  return check_done("test_adc");
+}
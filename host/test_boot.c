@@ -0,0 +1,31 @@
+/*
+ * The firmware boots on the simulated board and its main loop keeps
+ * sampling: SysTick follows the virtual clock, the mode menu reaches
+ * the panel and acquire_task() fills the history windows.
+ */
+#include "fw.h"
+#include "check.h"
+
+int main(void) {
+  int lit = 0;
+
+  fw_boot();
+  uint32_t t0 = msTicks;
+  fw_run(3000);
+
+  CHECK_RANGE(msTicks - t0, 3000, 3001);
+  CHECK(history[CH_TEMPERATURE].count > 0);
+  CHECK_RANGE(raw_latest[CH_TEMPERATURE], 249, 251);
+  CHECK_RANGE(raw_latest[CH_LIGHT], 90, 110);
+  CHECK_EQ(raw_latest[CH_POTENTIOMETER], 2048);
+  CHECK_EQ(sim.seg.ch, '1');
+
+  for (int y = 0; y < 64; y++)
+    for (int x = 0; x < 96; x++)
+      lit += sim_oled_pixel(x, y);
+  CHECK(lit > 0);
+  CHECK_EQ(sim.i2c.conflicts, 0);
+  CHECK_EQ(sim.ssp.conflicts, 0);
+
+  return check_done("test_boot");
+}
@@ -0,0 +1,57 @@
+/*
+ * Buttons with contact bounce: a short press gives one EV_SW3/EV_SW4
+ * on release, a long press only the long event, and the debounce
+ * latency from the first edge to the short event stays within
+ * DEBOUNCE_MS plus the bounce.
+ */
+#include "fw.h"
+#include "check.h"
+
+static uint8_t got[16];
+static int got_n;
+
+// vremeto odi napred bez glavnata jamka, nastanite ostanuvaat vo redicata
+static void wait_events(uint32_t ms) {
+  uint8_t ev;
+
+  sim_delay(ms * 1000);
+  got_n = 0;
+  while ((ev = event_get()) != EV_NONE)
+    if (got_n < 16)
+      got[got_n++] = ev;
+}
+
+static void check_press(int sw, uint32_t hold_ms, uint8_t ev) {
+  fw_press(sw, hold_ms);
+  wait_events(hold_ms + 100);
+  CHECK_EQ(got_n, 1);
+  CHECK_EQ(got[0], ev);
+}
+
+int main(void) {
+  fw_boot();
+  i2c_sync();
+  fw_run(100);
+  while (event_get() != EV_NONE)
+    ;
+
+  check_press(3, 150, EV_SW3);
+  check_press(4, 150, EV_SW4);
+  check_press(3, LONG_PRESS_MS + 300, EV_SW3_LONG);
+  check_press(4, LONG_PRESS_MS + 300, EV_SW4_LONG);
+
+  // kratkiot nastan stignuva duri po pustanjeto
+  fw_press(3, 400);
+  wait_events(300);
+  CHECK_EQ(got_n, 0);
+  wait_events(200);
+  CHECK_EQ(got_n, 1);
+  CHECK_EQ(got[0], EV_SW3);
+
+  printf("latency: SW3 %u ms, SW4 %u ms\n", sw3.latency_max, sw4.latency_max);
+  CHECK_RANGE(sw3.latency_max, DEBOUNCE_MS, DEBOUNCE_MS + 3);
+  CHECK_RANGE(sw4.latency_max, DEBOUNCE_MS, DEBOUNCE_MS + 3);
+  CHECK_EQ(ev_dropped, 0);
+
+  return check_done("test_buttons");
+}
@@ -0,0 +1,86 @@
+/*
+ * Vibration capture against the simulated MMA7455: 250 samples/s
+ * sustained with nothing lost, magnitude and peak in mg as the signal
+ * gives them, every TIMER1 tick accounted for as a sample or a skip,
+ * skips while the I2C queue is held by EEPROM writes, losses when the
+ * main loop stalls, and a streamed session read back whole.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define TICKS (sim.core.count[TIMER1_IRQn + 1])
+#define AMP 32 // 0.5 g po Z
+#define PEAK_MG ((ACC_LSB_PER_G + AMP) * 1000 / ACC_LSB_PER_G)
+
+static uint32_t t0;
+
+// sekoj tik na TIMER1 e primerok, preskoknat ili neuspesen
+static void check_ticks(void) {
+  i2c_sync();
+  CHECK_EQ(cap_stats.samples + cap_stats.skipped + cap_stats.failed, TICKS - t0);
+}
+
+int main(void) {
+  fw_boot();
+  sim.acc[2] = ACC_LSB_PER_G;
+  sim.acc_amp = AMP;
+  sim.acc_hz = 10;
+  fw_run(1000);
+
+  cap_start();
+  CHECK_EQ(ui_state, UI_CAPTURE);
+  t0 = TICKS;
+  uint32_t reads0 = sim.acc_dev.samples;
+  fw_run(5000);
+  printf("capture: %u samples, %u/s, peak %u mg, mag %u mg\n",
+         cap_stats.samples, cap_stats.rate, cap_stats.peak, cap_stats.mag);
+  CHECK_RANGE(cap_stats.rate, 245, 250);
+  CHECK_RANGE(cap_stats.samples, 5 * 250 - 2, 5 * 250);
+  CHECK(sim.acc_dev.samples - reads0 >= cap_stats.samples); // i read_acceleration() cita
+  CHECK_EQ(cap_stats.skipped, 0);
+  CHECK_EQ(cap_stats.failed, 0);
+  CHECK(cap_stats.overruns * 100 <= cap_stats.samples); // TIMER1 i senzorot se vo ista faza
+  CHECK_EQ(cap_stats.lost, 0);
+  CHECK_RANGE(cap_stats.peak, PEAK_MG - 20, PEAK_MG);
+  CHECK_RANGE(cap_stats.mag, (ACC_LSB_PER_G - AMP) * 1000 / ACC_LSB_PER_G - 20, PEAK_MG);
+  check_ticks();
+
+  // EEPROM zapisite ja polnat redicata, tikovite se preskoknuvaat
+  uint8_t page[EEPROM_PAGE_SIZE];
+  memset(page, 0x5a, sizeof(page));
+  for (int i = 0; i < 4 * I2C_QUEUE_SIZE; i++)
+    eeprom_write_async(page, (STORE_PAGES - 1 - i % 4) * EEPROM_PAGE_SIZE, 16);
+  fw_run(500);
+  printf("eeprom burst: %u skipped, %u overruns\n", cap_stats.skipped, cap_stats.overruns);
+  CHECK(cap_stats.skipped > 0);
+  CHECK_EQ(cap_stats.failed, 0);
+  check_ticks();
+
+  // glavnata jamka zaglavena 3 s, cap_buf se prepisuva
+  uint32_t samples = cap_stats.samples;
+  sim_delay(3000000);
+  fw_run(200);
+  uint32_t behind = cap_stats.samples - samples;
+  printf("stall: %u samples, %u lost\n", behind, cap_stats.lost);
+  CHECK_RANGE(cap_stats.lost, behind - CAP_BUF_SIZE - 60, behind - CAP_BUF_SIZE);
+  check_ticks();
+
+  // SW4 gi prakja blokovite vo EEPROM, eden zapis na CAP_SHOW_PERIOD
+  ui_event(EV_SW4);
+  CHECK(cap_store);
+  fw_run(REC_COUNT * CAP_SHOW_PERIOD + 1000);
+  CHECK(!cap_store);
+  CHECK_EQ(rec_n, REC_COUNT);
+  i2c_sync();
+  CHECK_EQ(procitaj(CH_ACCELERATION, 0), REC_COUNT);
+  CHECK(saved_committed);
+  for (int c = 0; c < ENV_BUCKETS; c++)
+    if (env_cols[c].n > 0) {
+      CHECK_EQ(env_cols[c].min, normalize_acceleration(ACC_LSB_PER_G + AMP));
+      CHECK_EQ(env_cols[c].max, normalize_acceleration(ACC_LSB_PER_G + AMP));
+    }
+
+  cap_stop();
+  CHECK(!LPC_TIM1->TCR);
+  return check_done("test_capture");
+}
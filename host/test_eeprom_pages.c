@@ -0,0 +1,65 @@
+/*
+ * Page-combined recording against the old scheme of one 11-byte
+ * eeprom_write() per sample: a REC_COUNT session has to cost about an
+ * order of magnitude fewer EEPROM page writes and write-cycle time, and
+ * has to read back whole.
+ */
+#include "fw.h"
+#include "check.h"
+
+int main(void) {
+  uint8_t rec[REC_SIZE];
+  uint8_t text[11];
+  int32_t v[CH_COUNT] = {0};
+  uint32_t pages, cycle_us, old_pages, old_cycle_us;
+
+  fw_boot();
+  i2c_sync();
+  sim_eeprom_erase();
+
+  // kako sto pravese glavnata jamka porano, zapisi od po 11 bajti
+  uint32_t w0 = sim.eeprom.page_writes;
+  uint64_t c0 = sim.eeprom.busy_us;
+  for (int i = 0; i < REC_COUNT; i++) {
+    memset(text, '0' + i % 10, sizeof(text));
+    eeprom_write(text, i * 11, sizeof(text));
+  }
+  Timer0_Wait(EEPROM_WRITE_MS);
+  old_pages = sim.eeprom.page_writes - w0;
+  old_cycle_us = sim.eeprom.busy_us - c0;
+  CHECK(old_pages > REC_COUNT); // zapisite preminuvaat granici na strani
+
+  sim_eeprom_erase();
+  store_init();
+  w0 = sim.eeprom.page_writes;
+  c0 = sim.eeprom.busy_us;
+  store_begin(0);
+  for (int i = 0; i < REC_COUNT; i++) {
+    v[CH_TEMPERATURE] = 200 + i;
+    v[CH_LIGHT] = i * 8;
+    v[CH_POTENTIOMETER] = i * 8;
+    record_encode(rec, v);
+    store_put(rec);
+    fw_run(10); // zapisite doagjaat eden po eden, kako od rec_drain
+  }
+  store_commit();
+  i2c_sync();
+  fw_run(EEPROM_WRITE_MS);
+  pages = sim.eeprom.page_writes - w0;
+  cycle_us = sim.eeprom.busy_us - c0;
+
+  printf("per session: %u page writes, %u us write cycle (11-byte writes: %u, %u us)\n",
+         pages, cycle_us, old_pages, old_cycle_us);
+  CHECK_RANGE(pages, (REC_COUNT + STORE_RECS_PER_PAGE - 1) / STORE_RECS_PER_PAGE,
+              (REC_COUNT + STORE_RECS_PER_PAGE - 1) / STORE_RECS_PER_PAGE + 1);
+  CHECK(pages * 9 <= old_pages);
+  CHECK(cycle_us * 9 <= old_cycle_us);
+  CHECK_EQ(store.record_bytes, REC_COUNT * REC_SIZE);
+
+  CHECK_EQ(procitaj(CH_POTENTIOMETER, 0), REC_COUNT);
+  CHECK_EQ(window_get( & measures, measures.count - 1), normalize_potentiometer((REC_COUNT - 1) * 8));
+  CHECK_EQ(i2c_stats.failed, 0);
+  CHECK_EQ(sim.i2c.conflicts, 0);
+
+  return check_done("test_eeprom_pages");
+}
@@ -0,0 +1,82 @@
+/*
+ * EEPROM writes through the I2C queue: back-to-back page writes and a
+ * partial last page all land, none of them is addressed
+ * during a write cycle, and other devices' jobs queued behind still
+ * complete. i2c_stats counts the bytes of every job on the bus and
+ * the deepest the queue got, and a job offered to a full queue is
+ * dropped and counted.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define PAGES 12
+#define BASE (20 * EEPROM_PAGE_SIZE)
+#define JOB_BYTES(tx, rx) (1 + (tx) + (rx)) // adresa, tx, rx
+
+int main(void) {
+  uint8_t page[EEPROM_PAGE_SIZE];
+
+  fw_boot();
+  i2c_sync();
+  sim_eeprom_erase();
+
+  uint32_t nacks = sim.eeprom.busy_nacks;
+  uint32_t failed = i2c_stats.failed;
+  uint32_t bytes = i2c_stats.bytes;
+  i2c_stats.depth_max = 0;
+
+  // vednas edna po druga, bez cekanje od povikuvacot
+  for (int p = 0; p < PAGES; p++) {
+    memset(page, p + 1, sizeof(page));
+    eeprom_write_async(page, BASE + p * EEPROM_PAGE_SIZE, sizeof(page));
+  }
+  memset(page, 0xaa, 10);
+  eeprom_write_async(page, BASE + PAGES * EEPROM_PAGE_SIZE, 10);
+  // redicata e polna, novata transakcija se frla
+  CHECK_EQ((uint8_t) (i2c_head - i2c_tail), I2C_QUEUE_SIZE);
+  CHECK_EQ(i2c_stats.depth_max, I2C_QUEUE_SIZE);
+  uint8_t reg = LIGHT_REG_LSB;
+  CHECK(!i2c_submit(LIGHT_I2C_ADDR, & reg, 1, 1, light_lsb_done));
+  CHECK_EQ(i2c_stats.dropped, 1);
+  // citanjeto na svetlinata ceka zad stranite vo redicata
+  while ((uint8_t) (i2c_head - i2c_tail) > I2C_QUEUE_SIZE - 2)
+    cpu_sleep();
+  CHECK(i2c_head != i2c_tail);
+  sim.lux = 321;
+  light_request();
+
+  i2c_sync();
+  CHECK_EQ(sim.eeprom.busy_nacks - nacks, 0);
+  CHECK_EQ(i2c_stats.failed - failed, 0);
+  CHECK_RANGE(light_lux, 320, 322);
+  CHECK_EQ(i2c_stats.dropped, 1);
+  CHECK_EQ(i2c_stats.depth_max, I2C_QUEUE_SIZE);
+  CHECK_EQ(i2c_stats.bytes - bytes, PAGES * JOB_BYTES(2 + EEPROM_PAGE_SIZE, 0) + JOB_BYTES(2 + 10, 0) +
+           2 * JOB_BYTES(1, 1));
+
+  uint8_t * e = sim_eeprom();
+  for (int p = 0; p < PAGES; p++)
+    for (int i = 0; i < EEPROM_PAGE_SIZE; i++)
+      CHECK_EQ(e[BASE + p * EEPROM_PAGE_SIZE + i], p + 1);
+  for (int i = 0; i < 10; i++)
+    CHECK_EQ(e[BASE + PAGES * EEPROM_PAGE_SIZE + i], 0xaa);
+  CHECK_EQ(e[BASE + PAGES * EEPROM_PAGE_SIZE + 10], 0xff);
+
+  // blokirackiot drajver posle i2c_sync() ne naiduva na ciklus za zapis
+  eeprom_write_async(page, BASE, 4);
+  i2c_sync();
+  eeprom_read(page, BASE, 4);
+  CHECK_EQ(page[0], 0xaa);
+  CHECK_EQ(sim.eeprom.busy_nacks - nacks, 0);
+
+  // zapis i citanje na svetlinata: tri transakcii vo redicata
+  i2c_stats.depth_max = 0;
+  bytes = i2c_stats.bytes;
+  eeprom_write_async(page, BASE, 4);
+  light_request();
+  i2c_sync();
+  CHECK_EQ(i2c_stats.depth_max, 3);
+  CHECK_EQ(i2c_stats.bytes - bytes, JOB_BYTES(2 + 4, 0) + 2 * JOB_BYTES(1, 1));
+
+  return check_done("test_eeprom_queue");
+}
@@ -0,0 +1,66 @@
+/*
+ * Shadow framebuffer: fb_flush() sends only the columns that changed,
+ * the byte counters agree with what reached the panel, and the panel
+ * ends up showing exactly fb[]. The DMA refresh never polls SSP1 and
+ * never lets its receive FIFO overflow.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define FULL_FRAME (OLED_PAGES * (3 + OLED_DISPLAY_WIDTH))
+
+static void check_panel(void) {
+  oled_wait();
+  for (int y = 0; y < OLED_DISPLAY_HEIGHT; y++)
+    for (int x = 0; x < OLED_DISPLAY_WIDTH; x++)
+      CHECK_EQ(sim_oled_pixel(x, y), (fb[y >> 3][x] >> (y & 7)) & 1);
+}
+
+int main(void) {
+  uint32_t sent, graph_max = 0, graph_sum = 0;
+
+  fw_boot();
+  oled_wait();
+  uint64_t spin = sim.core.spin_us;
+
+  display_working_modes();
+  check_panel();
+
+  // ist ekran, nisto ne se prakja
+  sent = sim.oled.bytes;
+  CHECK_EQ(fb_flush(), 0);
+  oled_wait();
+  CHECK_EQ(sim.oled.bytes, sent);
+
+  // grafik: samo kolonite okolu novata tocka i pomestenata kriva
+  window_clear( & history[CH_POTENTIOMETER]);
+  draw_graph_real_time( & history[CH_POTENTIOMETER], channel_names[CH_POTENTIOMETER]);
+  oled_wait();
+  for (int i = 0; i < 40; i++) {
+    window_push( & history[CH_POTENTIOMETER], normalize_potentiometer(i % 4 ? 2000 : 2100));
+    sent = sim.oled.bytes;
+    draw_graph_real_time( & history[CH_POTENTIOMETER], channel_names[CH_POTENTIOMETER]);
+    oled_wait();
+    CHECK_EQ(sim.oled.bytes - sent, fb_stats.last_frame_bytes);
+    if (i >= WINDOW_DEPTH) {
+      graph_sum += fb_stats.last_frame_bytes;
+      if (fb_stats.last_frame_bytes > graph_max)
+        graph_max = fb_stats.last_frame_bytes;
+    }
+  }
+  check_panel();
+  printf("graph frame: %u bytes max, %u mean, full frame %u\n", graph_max,
+         graph_sum / (40 - WINDOW_DEPTH), FULL_FRAME);
+  CHECK(graph_max < FULL_FRAME);
+  CHECK(graph_sum / (40 - WINDOW_DEPTH) < FULL_FRAME / 2);
+
+  display_measurement_options();
+  check_panel();
+  CHECK(fb_stats.last_frame_bytes <= FULL_FRAME);
+  CHECK_EQ(sim.core.spin_us - spin, 0);
+  CHECK_EQ(sim.ssp.overruns, 0);
+  CHECK_EQ(sim.oled.dc_glitches, 0);
+  CHECK_EQ(fb_stats.dma_errors, 0);
+
+  return check_done("test_framebuffer");
+}
@@ -0,0 +1,112 @@
+/*
+ * Idle accounting: with nothing to do the CPU sleeps in WFI and the
+ * SysTick that wakes it counts as sleep, so TLM_DUTY on the idle menu
+ * stays low instead of reading about 1000 per mille. Blocking waits
+ * (i2c_sync() behind EEPROM write cycles, oled_wait()) sleep as well.
+ * The firmware's own code is charged to the virtual clock through
+ * cpu_scale, so some second of every stretch reports a non-zero duty.
+ * Built with IDLE_WFI=0 as test_idle_busy, the same waits spin and the
+ * duty reads close to 1000 per mille. Both builds print the duty and
+ * the charged code time of the menu, the EEPROM writes and the
+ * real-time view.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define CPU_SCALE 100 // ns na plocata za 1 ns na hostot, LPC1769 na 120 MHz bez kes
+
+#if IDLE_WFI
+#define NAME "wfi"
+#else
+#define NAME "busy"
+#endif
+
+// najgolemiot TLM_DUTY paket izlezen na UART3 od bajtot from, -1 ako nema
+static int32_t max_duty(uint32_t from) {
+  int32_t duty = -1;
+
+  for (uint32_t i = from; i + TLM_PACKET_SIZE <= sim.uart.len; i++) {
+    const uint8_t * p = & sim.uart.out[i];
+    uint8_t sum = 0;
+    if (p[0] != TLM_SYNC || p[2] != TLM_DUTY)
+      continue;
+    for (int k = 1; k < TLM_PACKET_SIZE; k++)
+      sum += p[k];
+    int32_t d = p[7] | p[8] << 8 | p[9] << 16 | (uint32_t) p[10] << 24;
+    if (sum == 0 && d > duty)
+      duty = d;
+  }
+  return duty;
+}
+
+// kodot naplaten od c0 navamu, vo promili od ms
+static uint32_t cpu_per_mille(uint64_t c0, uint32_t ms) {
+  return (sim.core.cpu_us - c0) / ms;
+}
+
+int main(void) {
+  // bez cpu_scale praznoto cekanje ne go pomestuva virtuelnoto vreme
+  sim_reset();
+  sim.cpu_scale = CPU_SCALE;
+  init_app();
+  fw_run(2000);
+
+  // meni, samo vzorkuvanjeto na 200 ms
+  uint32_t a0 = idle_stats.active_ticks, s0 = idle_stats.sleep_ticks;
+  uint32_t u0 = sim.uart.len;
+  uint64_t c0 = sim.core.cpu_us;
+  fw_run(5000);
+  uint32_t active = idle_stats.active_ticks - a0, sleep = idle_stats.sleep_ticks - s0;
+  int32_t duty = max_duty(u0);
+  printf("%s menu: %u active, %u sleep ticks, duty up to %d per mille, code %u per mille\n", NAME, active,
+         sleep, duty, cpu_per_mille(c0, 5000));
+  CHECK_RANGE(active + sleep, 5000, 5002); // naplateniot kod moze da pomine preku krajot
+  CHECK(active > 0);
+#if IDLE_WFI
+  CHECK_RANGE(duty, 1, 100);
+  CHECK(active * 10 < sleep);
+#else
+  CHECK_RANGE(duty, 900, 1000);
+  CHECK(sleep * 10 < active);
+#endif
+
+  // i2c_sync() ceka na ciklusite za zapis spiejki
+  uint8_t page[EEPROM_PAGE_SIZE];
+  memset(page, 0xa5, sizeof(page));
+  a0 = idle_stats.active_ticks;
+  s0 = idle_stats.sleep_ticks;
+  for (int i = 0; i < 16; i++)
+    eeprom_write_async(page, (STORE_PAGES - 1 - i) * EEPROM_PAGE_SIZE, sizeof(page) - 2);
+  i2c_sync();
+  active = idle_stats.active_ticks - a0;
+  sleep = idle_stats.sleep_ticks - s0;
+  printf("%s i2c_sync: %u active, %u sleep ticks\n", NAME, active, sleep);
+  CHECK(active + sleep >= 16 * EEPROM_WRITE_MS - 2);
+#if IDLE_WFI
+  CHECK(active * 10 < sleep);
+#else
+  CHECK(sleep * 10 < active);
+#endif
+
+  // realnoto vreme go crta grafikot na sekoj primerok, panelot odi preku DMA
+  mode = MODE_REALTIME;
+  sel_ch = CH_TEMPERATURE;
+  start_view();
+  u0 = sim.uart.len;
+  c0 = sim.core.cpu_us;
+  fw_run(3000);
+  oled_wait();
+  duty = max_duty(u0);
+  printf("%s realtime: duty up to %d per mille, code %u per mille\n", NAME, duty, cpu_per_mille(c0, 3000));
+#if IDLE_WFI
+  CHECK_RANGE(duty, 1, 100);
+#else
+  CHECK_RANGE(duty, 900, 1000);
+#endif
+
+#if IDLE_WFI
+  return check_done("test_idle");
+#else
+  return check_done("test_idle_busy");
+#endif
+}
@@ -0,0 +1,74 @@
+/*
+ * LED bar and 7-segment output per 1000 LED ticks. The LED timer runs
+ * every LED_PERIOD (100 ms), twice per 200 ms graph sample, so 1000
+ * ticks are 500 samples. The real-time view on slowly rising, slightly
+ * noisy light sends the PCA9532 only the bar changes. The old driver,
+ * replayed through the same LED task by forgetting the shadow before
+ * every tick, wrote it on every tick. The bar on the board always
+ * matches the last value on the graph. Repeating the same digit does
+ * not go out on SSP1.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define TICKS 1000
+
+static uint32_t changes;
+
+// TICKS povici na led_task() od temnina, vrakja kolku zapisi otisle do PCA9532
+static uint32_t run_ticks(int coalesce) {
+  int level = -1;
+
+  sim.lux = 0;
+  fw_run(1000);
+  i2c_sync();
+  changes = 0;
+  uint32_t w0 = sim.pca.writes;
+  uint32_t out0 = out_stats.led_writes;
+  uint32_t runs0 = timers[TMR_LEDS].runs;
+  for (uint32_t n = 0; n < TICKS; n = timers[TMR_LEDS].runs - runs0) {
+    sim.lux = n * 2 + (n & 1) * 20; // 0..2000 lux, so sum od 20 lux
+    if (!coalesce)
+      led_shadow = -1; // kako porano, sekoj tik odi na magistralata
+    fw_run(LED_PERIOD);
+    i2c_sync(); // zapisot za PCA9532 e izlezen
+    int l = led_level(window_get(active_window, active_window->count - 1));
+    if (l != level)
+      changes++;
+    level = l;
+    CHECK_EQ(sim.pca.leds, led_bar[l] << 8);
+  }
+  CHECK_EQ(timers[TMR_LEDS].runs - runs0, TICKS);
+  CHECK_EQ(out_stats.led_writes - out0, sim.pca.writes - w0);
+  return sim.pca.writes - w0;
+}
+
+int main(void) {
+  fw_boot();
+  fw_run(1000);
+
+  // istiot pogled za dvete, tikovite se vo ista faza so vzorkuvanjeto
+  mode = MODE_REALTIME;
+  sel_ch = CH_LIGHT;
+  start_view();
+  uint32_t old_writes = run_ticks(0);
+  uint32_t old_changes = changes;
+  uint32_t writes = run_ticks(1);
+  stop_view();
+
+  printf("per %u LED ticks (%u graph samples): %u PCA9532 writes for %u bar changes (every tick: %u)\n",
+         TICKS, TICKS * LED_PERIOD / SAMPLE_PERIOD, writes, changes, old_writes);
+  CHECK_EQ(old_writes, TICKS);
+  CHECK_EQ(changes, old_changes);
+  CHECK_RANGE(writes, 1, changes);
+  CHECK(writes * 20 <= old_writes);
+
+  // istiot znak na 7seg ne odi po SSP1
+  uint32_t s0 = sim.seg.writes;
+  for (int i = 0; i < TICKS; i++)
+    seg_setChar(i < TICKS / 2 ? '3' : '4');
+  CHECK_EQ(sim.seg.writes - s0, 2);
+  CHECK_EQ(sim.seg.ch, '4');
+
+  return check_done("test_leds");
+}
@@ -0,0 +1,168 @@
+/*
+ * Deferred log end to end: log_flush() sends the records on UART3
+ * between telemetry packets, and tools/logexpand turns every LOG_* ID
+ * back into its text, including the %s name tables.
+ *
+ * Built with PROFILE 1 as test_log_prof, it also checks the profiler:
+ * a long SW4 press after some real-time sampling has to come out as
+ * the header, one line per scope that ran and the tail of the trace,
+ * with the numbers the scopes collected.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define TOOL "build/logexpand"
+#if PROFILE
+#define STREAM "build/test_log_prof.bin"
+#define TOOL_ERR "build/test_log_prof.err"
+#else
+#define STREAM "build/test_log.bin"
+#define TOOL_ERR "build/test_log.err"
+#endif
+
+static const char * expect[] = {
+  "ch7seg++: -3",
+  "recorded 90 records, 11 page writes",
+  "scope count min avg max (cycles)",
+  "eeprom 10 1 2 3",
+  "@77 draw 12",
+};
+
+static char lines[64][128];
+static int line_n;
+
+// UART3 bez paketi vo letot
+static void drain(void) {
+  while (tlm_tail != tlm_head)
+    sim_delay(1000);
+  sim_delay(2000);
+}
+
+static void expand(uint32_t from) {
+  uint32_t records, unknown, packets, bad, skipped;
+
+  FILE * f = fopen(STREAM, "wb");
+  fwrite(sim.uart.out + from, 1, sim.uart.len - from, f);
+  fclose(f);
+
+  FILE * out = popen(TOOL " " STREAM " 2>" TOOL_ERR, "r");
+  CHECK(out != NULL);
+  line_n = 0;
+  while (line_n < (int) (sizeof(lines) / sizeof(lines[0])) && fgets(lines[line_n], sizeof(lines[0]), out)) {
+    lines[line_n][strcspn(lines[line_n], "\n")] = '\0';
+    line_n++;
+  }
+  pclose(out);
+
+  FILE * err = fopen(TOOL_ERR, "r");
+  CHECK(err != NULL);
+  CHECK_EQ(fscanf(err, "records %u unknown %u packets %u bad %u skipped bytes %u",
+                  & records, & unknown, & packets, & bad, & skipped), 5);
+  fclose(err);
+  printf("logexpand: %u records, %u packets\n", records, packets);
+  CHECK_EQ(records, line_n);
+  CHECK(packets > 0);
+  CHECK_EQ(unknown, 0);
+  CHECK_EQ(skipped, 0);
+}
+
+// tekstot posle "t_ms: "
+static const char * text(int i) {
+  const char * p = strstr(lines[i], ": ");
+  return p ? p + 2 : "";
+}
+
+#if PROFILE
+// po redosled na PRF_*
+static const char * scopes[] = {"sensors", "normalize", "draw", "flush", "leds", "eeprom"};
+
+// izvestajot od prof_dump() so vrednostite vo momentot na pritiskot
+static void check_prof(void) {
+  char want[128];
+  prof_stat_t st[PRF_COUNT];
+  prof_trace_t tr[PROF_TRACE_SIZE];
+
+  mode = MODE_REALTIME;
+  sel_ch = CH_LIGHT;
+  start_view();
+  fw_run(3000);
+  drain();
+  uint32_t from = sim.uart.len;
+
+  ui_event(EV_SW4_LONG);
+  memcpy(st, prof_stats, sizeof(st));
+  memcpy(tr, prof_trace, sizeof(tr));
+  uint32_t head = prof_trace_head;
+  fw_run(500);
+  drain();
+  CHECK_EQ(log_stats.dropped, 0);
+  expand(from);
+
+  int k = 0;
+  CHECK(!strcmp(text(k++), "scope count min avg max (cycles)"));
+  for (int i = 0; i < PRF_COUNT; i++) {
+    if (st[i].count == 0)
+      continue;
+    snprintf(want, sizeof(want), "%s %u %u %u %u", scopes[i], st[i].count, st[i].min,
+             (uint32_t) (st[i].sum / st[i].count), st[i].max);
+    CHECK(!strcmp(text(k++), want));
+    CHECK(st[i].min <= st[i].max);
+  }
+  // sekoj primerok: senzori, normalizacija, grafik, flush; LED na 100 ms
+  CHECK(st[PRF_SENSORS].count >= 3000 / SAMPLE_PERIOD);
+  CHECK_EQ(st[PRF_NORMALIZE].count, st[PRF_SENSORS].count);
+  CHECK(st[PRF_DRAW].count >= 3000 / SAMPLE_PERIOD);
+  CHECK(st[PRF_FLUSH].count >= st[PRF_DRAW].count);
+  CHECK(st[PRF_LEDS].count >= 3000 / LED_PERIOD - 1);
+  CHECK(st[PRF_DRAW].max > 0);
+
+  CHECK(head >= PROF_DUMP_TRACE);
+  for (uint32_t i = head - PROF_DUMP_TRACE; i != head; i++) {
+    prof_trace_t * t = & tr[i & (PROF_TRACE_SIZE - 1)];
+    snprintf(want, sizeof(want), "@%u %s %u", t->at, scopes[t->scope], t->ticks);
+    CHECK(!strcmp(text(k++), want));
+  }
+  CHECK(!strncmp(text(k++), "active ", 7)); // LOG_IDLE po izvestajot
+  CHECK_EQ(k, line_n);
+  for (int i = 0; i < line_n; i++)
+    printf("  %s\n", lines[i]);
+}
+#endif
+
+int main(void) {
+  fw_boot();
+  fw_run(1000);
+  drain();
+  uint32_t from = sim.uart.len;
+
+  // od glavnata jamka, pomegju telemetrijata
+  LOG(LOG_CH7SEG, -3);
+  LOG(LOG_RECORD_DONE, 90, 11);
+  LOG(LOG_PROF_HEADER, 0);
+  LOG(LOG_PROF_STAT, PRF_EEPROM, 10, 1, 2, 3);
+  LOG(LOG_PROF_TRACE, 77, PRF_DRAW, 12);
+  // sekoj ID so LOG_MAX_ARGS argumenti
+  for (int id = 0; id < LOG_COUNT; id++)
+    LOG(id, 1, 2, 3, 4, 5);
+  fw_run(500);
+  drain();
+
+  CHECK_EQ(log_stats.dropped, 0);
+  expand(from);
+  CHECK_EQ(line_n, 5 + LOG_COUNT);
+  for (int i = 0; i < 5; i++)
+    CHECK(!strcmp(text(i), expect[i]));
+  for (int i = 5; i < line_n; i++) {
+    CHECK(strchr(text(i), '?') == NULL);
+    CHECK(strstr(text(i), "log id") == NULL);
+  }
+  for (int i = 0; i < line_n; i++)
+    printf("  %s\n", lines[i]);
+
+#if PROFILE
+  check_prof();
+  return check_done("test_log_prof");
+#else
+  return check_done("test_log");
+#endif
+}
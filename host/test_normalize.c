@@ -0,0 +1,51 @@
+/*
+ * The fixed-point normalize_* kernels against the double arithmetic they
+ * replaced, over every input the channels can deliver: at most one
+ * graph pixel apart.
+ */
+#include "fw.h"
+#include "check.h"
+
+static int32_t ref_temperature(int32_t val) {
+  double v = (double) val;
+  v = v / 10;
+  return (int32_t) ((((v - 15) / 20) * 43) + 10);
+}
+
+static int32_t ref_light(int32_t val) {
+  return (int32_t) ((((double) val / 4000) * 43) + 10);
+}
+
+static int32_t ref_potentiometer(int32_t val) {
+  return (int32_t) ((((double) val / 4095) * 43) + 10);
+}
+
+static int32_t ref_acceleration(int32_t val) {
+  return (int32_t) (((((double) val + 128) / 256) * 43) + 10);
+}
+
+static void check_channel(int32_t (* q)(int32_t), int32_t (* ref)(int32_t), int32_t from, int32_t to) {
+  for (int32_t v = from; v <= to; v++)
+    CHECK_RANGE(q(v) - ref(v), -1, 1);
+}
+
+#define Q_WRAP(name, fn) static int32_t name(int32_t v) { return (int32_t) fn(v); }
+Q_WRAP(q_temperature, normalize_temperature)
+Q_WRAP(q_light, normalize_light)
+Q_WRAP(q_potentiometer, normalize_potentiometer)
+Q_WRAP(q_acceleration, normalize_acceleration)
+
+int main(void) {
+  // pod 10.4 C starata verzija davase negativen double
+  check_channel(q_temperature, ref_temperature, 104, 1500);
+  check_channel(q_light, ref_light, 0, 65535);
+  check_channel(q_potentiometer, ref_potentiometer, 0, 4095);
+  check_channel(q_acceleration, ref_acceleration, -128, 127);
+
+  // krajnite tocki na grafikot
+  CHECK_EQ(normalize_potentiometer(0), 10);
+  CHECK_EQ(normalize_potentiometer(4095), 53);
+  CHECK_EQ(normalize_temperature(0), 0);
+
+  return check_done("test_normalize");
+}
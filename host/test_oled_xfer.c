@@ -0,0 +1,62 @@
+/*
+ * OLED refresh cost on the real-time graph, built once with GPDMA and
+ * once with OLED_USE_DMA 0 (test_oled_xfer_polled). Both print the
+ * transfer time and the time the CPU spent waiting for SSP1 per frame
+ * in the same line format, so the two runs read side by side. The
+ * polled path waits for the whole transfer, the DMA path only when a
+ * new frame or the 7-segment display needs the bus before it is free.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define RUN_MS 10000
+
+int main(void) {
+  fw_boot();
+  fw_run(1000);
+  oled_wait();
+
+  mode = MODE_REALTIME;
+  sel_ch = CH_POTENTIOMETER;
+  start_view();
+  fw_run(2000); // prozorecot e poln, se crta samo pomestuvanjeto
+  oled_wait();
+
+  uint32_t frames = fb_stats.frames, bytes = fb_stats.bytes;
+  uint32_t xfer = fb_stats.xfer_us_sum, busy = fb_stats.cpu_busy_us;
+  uint64_t spin = sim.core.spin_us;
+  fb_stats.xfer_us_max = 0;
+  for (uint32_t t = 0; t < RUN_MS; t += SAMPLE_PERIOD) {
+    sim.pot = t % 2000 < 1000 ? 1000 : 3000;
+    fw_run(SAMPLE_PERIOD);
+  }
+  oled_wait();
+  frames = fb_stats.frames - frames;
+  bytes = fb_stats.bytes - bytes;
+  xfer = fb_stats.xfer_us_sum - xfer;
+  busy = fb_stats.cpu_busy_us - busy;
+
+  printf("oled %s: %u frames, %u bytes/frame, xfer %u us/frame (max %u), cpu busy %u us/frame\n",
+         OLED_USE_DMA ? "dma" : "polled", frames, bytes / frames, xfer / frames, fb_stats.xfer_us_max,
+         busy / frames);
+  CHECK_RANGE(frames, RUN_MS / SAMPLE_PERIOD - 1, RUN_MS / SAMPLE_PERIOD + 1);
+  // SSP1 ne moze da bide pobrz od bajtite na zicata
+  CHECK(xfer >= bytes * sim_ssp_byte_us());
+  CHECK(fb_stats.xfer_us_max > 0);
+  CHECK(fb_stats.xfer_us_max < 1000 * SAMPLE_PERIOD);
+  CHECK_EQ(fb_stats.dma_errors, 0);
+#if OLED_USE_DMA
+  CHECK(busy * 10 < xfer);
+  CHECK_EQ(sim.core.spin_us - spin, 0);
+#else
+  CHECK_EQ(busy, xfer);
+  CHECK(sim.core.spin_us - spin > 0);
+#endif
+
+  // panelot go pokazuva fb[] i po dvata pata
+  for (int y = 0; y < OLED_DISPLAY_HEIGHT; y++)
+    for (int x = 0; x < OLED_DISPLAY_WIDTH; x++)
+      CHECK_EQ(sim_oled_pixel(x, y), (fb[y >> 3][x] >> (y & 7)) & 1);
+
+  return check_done(OLED_USE_DMA ? "test_oled_xfer" : "test_oled_xfer_polled");
+}
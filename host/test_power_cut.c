@@ -0,0 +1,155 @@
+/*
+ * Power cut during recording. A first boot records part of a session
+ * and loses power on the k-th EEPROM page write, with only some bytes
+ * of that write arriving; a second boot has to find the head, keep the
+ * previous session whole, and carry the cut session on to REC_COUNT
+ * records marked as resumed and committed. Every write of the session
+ * is cut in turn, at several points within the write. A capture
+ * session is not resumed and reads back as not committed.
+ */
+#define REC_COUNT 90 // kratki sesii, sekoj zapis od sesijata se preseca
+#include "fw.h"
+#include "check.h"
+
+#define FIRST_RECS 30
+#define FIRST_SESSION 1 // prvata posle brisenjeto
+#define MAX_WRITES 64
+#define PERIOD 1 // 250 ms, zapisite odat i po stranata i po STORE_FLUSH_MS
+#define RUN_MS 40000
+#define NO_CUT 2
+#define RESUMED 3
+
+static const uint8_t cut_bytes[] = {0, 3, 6, 10, 64};
+static uint8_t image[SIM_EEPROM_SIZE];
+static uint32_t cut_k;
+static uint8_t cut_b;
+
+// izlezot na deteto, 1 ako nesto ne e vo red
+static void child_exit(int st) {
+  fflush(stdout);
+  _exit(check_failed ? 1 : st);
+}
+
+// prethodnata sesija, zatvorena
+static void first_session(void) {
+  int32_t v[CH_COUNT] = {0};
+
+  fw_boot();
+  i2c_sync();
+  store_begin(0);
+  for (int i = 0; i < FIRST_RECS; i++) {
+    v[CH_TEMPERATURE] = 100 + i;
+    zapisi(v);
+  }
+  store_commit();
+  i2c_sync();
+  fw_run(EEPROM_WRITE_MS);
+  child_exit(0);
+}
+
+// snimanjeto od menito, strujata se isklucuva na cut_k-tiot zapis od sesijata
+static void cut_recording(void) {
+  fw_boot();
+  CHECK_EQ(ui_state, UI_MODES);
+  sim.eeprom.cut_at = sim.eeprom.page_writes + cut_k;
+  sim.eeprom.cut_bytes = cut_b;
+  ch7seg = '1' + PERIOD;
+  rec_n = 0;
+  store_begin(ch7seg - '1');
+  ui_state = UI_RECORDING;
+  rec_clock_start(rec_periods[ch7seg - '1'], REC_COUNT);
+  fw_run(RUN_MS);
+  child_exit(NO_CUT); // zapisot cut_k ne dojde
+}
+
+static void recovery(void) {
+  fw_boot();
+  if (ui_state == UI_RECORDING) {
+    CHECK_EQ(ch7seg, '1' + PERIOD);
+    uint64_t end = sim_now() + (uint64_t) RUN_MS * 1000;
+    while (ui_state == UI_RECORDING && sim_now() < end)
+      fw_run(100);
+    CHECK_EQ(ui_state, UI_MODES);
+    fw_run(EEPROM_WRITE_MS);
+
+    CHECK_EQ(procitaj(CH_TEMPERATURE, 0), REC_COUNT);
+    CHECK(saved_committed);
+    CHECK(saved_resumed);
+    for (int i = 0; i < REC_COUNT; i++) {
+      CHECK_EQ(env_cols[i].min, normalize_temperature(sim.temp));
+      CHECK_EQ(env_cols[i].max, normalize_temperature(sim.temp));
+    }
+    child_exit(RESUMED);
+  } else if (store.session != FIRST_SESSION) {
+    // strujata se isklucila po zapisot so STORE_COMMIT
+    CHECK_EQ(procitaj(CH_TEMPERATURE, 0), REC_COUNT);
+    CHECK(saved_committed);
+    CHECK(!saved_resumed);
+  } else {
+    // od sesijata ne stigna nisto, ostanuva prethodnata
+    CHECK_EQ(procitaj(CH_TEMPERATURE, 0), FIRST_RECS);
+    CHECK(saved_committed);
+    CHECK(!saved_resumed);
+    CHECK_EQ(window_get( & measures, measures.count - 1), normalize_temperature(100 + FIRST_RECS - 1));
+  }
+  child_exit(0);
+}
+
+static void cut_capture(void) {
+  fw_boot();
+  sim.eeprom.cut_at = sim.eeprom.page_writes + 3;
+  cap_start();
+  rec_n = 0;
+  store_begin(STORE_NO_PERIOD);
+  cap_store = 1;
+  fw_run(RUN_MS);
+  child_exit(NO_CUT);
+}
+
+static void capture_recovery(void) {
+  fw_boot();
+  CHECK_EQ(ui_state, UI_MODES);
+  CHECK(!store.committed);
+  int n = procitaj(CH_ACCELERATION, 0);
+  CHECK_RANGE(n, 2 * STORE_RECS_PER_PAGE, 3 * STORE_RECS_PER_PAGE);
+  CHECK(!saved_committed);
+  CHECK(!saved_resumed);
+  child_exit(0);
+}
+
+int main(void) {
+  uint32_t cuts = 0, resumed = 0;
+
+  sim_eeprom_erase();
+  CHECK_EQ(fw_fork(first_session), 0);
+  memcpy(image, sim_eeprom(), sizeof(image));
+
+  for (cut_k = 1; cut_k < MAX_WRITES; cut_k++) {
+    int st = 0;
+    for (uint32_t b = 0; b < sizeof(cut_bytes); b++) {
+      cut_b = cut_bytes[b];
+      memcpy(sim_eeprom(), image, sizeof(image));
+      st = fw_fork(cut_recording);
+      if (st == NO_CUT)
+        break;
+      CHECK_EQ(st, 0);
+      cuts++;
+
+      st = fw_fork(recovery);
+      if (st != 0 && st != RESUMED)
+        printf("cut at write %u, %u bytes: recovery failed\n", cut_k, cut_b);
+      CHECK(st == 0 || st == RESUMED);
+      resumed += st == RESUMED;
+    }
+    if (st == NO_CUT)
+      break;
+  }
+  printf("%u power cuts over %u page writes of a session, %u resumed\n", cuts, cut_k - 1, resumed);
+  CHECK_RANGE(cut_k, REC_COUNT / STORE_RECS_PER_PAGE, MAX_WRITES - 1);
+
+  memcpy(sim_eeprom(), image, sizeof(image));
+  CHECK_EQ(fw_fork(cut_capture), 0);
+  CHECK_EQ(fw_fork(capture_recovery), 0);
+
+  return check_done("test_power_cut");
+}
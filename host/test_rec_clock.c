@@ -0,0 +1,104 @@
+/*
+ * The recording clock on the virtual microsecond clock: sessions stay
+ * on the grid of absolute deadlines with no drift, every record holds
+ * readings taken after the previous deadline, masked interrupts count
+ * as lateness and missed deadlines, and a session that drops records
+ * behind a stalled main loop still ends and commits what it kept.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define STEP_US 1000
+
+static int32_t light[REC_COUNT];
+static int32_t acc[REC_COUNT];
+static int taken;
+
+// glavnata jamka po STEP_US, vleznite vrednosti sledat od vremeto
+static void run_session(int digit) {
+  uint32_t period = rec_periods[digit - 1];
+  uint64_t t0 = sim_now();
+  uint64_t end = t0 + (uint64_t) period * (REC_COUNT + 10) * 1000;
+  uint8_t seen = rec_q_tail;
+
+  taken = 0;
+  while (ui_state == UI_RECORDING && sim_now() < end) {
+    uint64_t ms = (sim_now() - t0) / 1000;
+    sim.lux = 10 + ms * 8 / period; // 8 lux po period, REC_COUNT periodi pod LIGHT_RANGE
+    sim.acc[2] = (int8_t) (ms * 2 / period);
+    fw_run_until(sim_now() + STEP_US);
+    for (; seen != rec_q_head && taken < REC_COUNT; seen++, taken++) {
+      light[taken] = rec_q[seen & (REC_QUEUE_SIZE - 1)].v[CH_LIGHT];
+      acc[taken] = rec_q[seen & (REC_QUEUE_SIZE - 1)].v[CH_ACCELERATION];
+    }
+  }
+}
+
+static void start(int digit) {
+  ch7seg = '0' + digit;
+  mode = MODE_SAVE;
+  ui_state = UI_CHOOSE_TIME;
+  ui_event(EV_SW4);
+  CHECK_EQ(ui_state, UI_RECORDING);
+}
+
+int main(void) {
+  fw_boot();
+  fw_run(1000);
+
+  // 200 ms i 1 s, bez pomestuvanje od mrezata
+  for (int digit = 1; digit <= 4; digit += 3) {
+    uint32_t period_us = rec_periods[digit - 1] * 1000;
+    start(digit);
+    uint64_t t0 = sim_now();
+    run_session(digit);
+    printf("period %u ms: %d records in %u ms, late max %u us, missed %u\n", period_us / 1000,
+           rec_n, (unsigned) ((sim_now() - t0) / 1000), rec_clock.late_max, rec_clock.missed);
+    CHECK_EQ(ui_state, UI_MODES);
+    CHECK_EQ(rec_n, REC_COUNT);
+    CHECK_EQ(taken, REC_COUNT);
+    CHECK_EQ(rec_clock.deadline, (REC_COUNT - 1) * period_us);
+    CHECK_RANGE(sim_now() - t0, (uint64_t) (REC_COUNT - 1) * period_us, (uint64_t) (REC_COUNT - 1) * period_us + 2 * STEP_US);
+    CHECK_EQ(rec_clock.missed, 0);
+    CHECK_EQ(rec_clock.dropped, 0);
+    CHECK(rec_clock.late_max < 100);
+
+    // sekoj zapis ima citanja od po prethodniot rok, prviot gi zema poslednite od pred startot
+    for (int i = 2; i < REC_COUNT; i++) {
+      CHECK(light[i] > light[i - 1]);
+      CHECK(acc[i] != acc[i - 1]);
+    }
+    CHECK_EQ(procitaj(CH_LIGHT, 0), REC_COUNT);
+    CHECK(saved_committed);
+  }
+
+  // 800 ms so maskirani prekini na 250 ms, odmah po rok: dva propusteni, treiot docnat 50 ms
+  start(2);
+  fw_run(1000);
+  __disable_irq();
+  sim_delay(800000);
+  __enable_irq();
+  run_session(2);
+  printf("masked 800 ms at 250 ms: late max %u us, missed %u, %d records\n",
+         rec_clock.late_max, rec_clock.missed, rec_n);
+  CHECK_EQ(rec_clock.missed, 2);
+  CHECK_RANGE(rec_clock.late_max, 50000, 50000 + STEP_US);
+  CHECK_EQ(rec_n, REC_COUNT); // propustenite rokovi ne se zapisi
+  CHECK_EQ(ui_state, UI_MODES);
+
+  // glavnata jamka zaglavena 3 s: rec_q se polni, ostatokot se frla
+  start(1);
+  fw_run(1000);
+  sim_delay(3000000);
+  run_session(1);
+  printf("stalled 3 s at 200 ms: dropped %u, depth max %u, %d records\n",
+         rec_clock.dropped, rec_clock.depth_max, rec_n);
+  CHECK_EQ(ui_state, UI_MODES);
+  CHECK_RANGE(rec_clock.dropped, 3000 / 200 - REC_QUEUE_SIZE - 1, 3000 / 200 - REC_QUEUE_SIZE + 1);
+  CHECK_EQ(rec_clock.depth_max, REC_QUEUE_SIZE);
+  CHECK_EQ(rec_n, REC_COUNT - rec_clock.dropped);
+  CHECK_EQ(procitaj(CH_LIGHT, 0), rec_n);
+  CHECK(saved_committed);
+
+  return check_done("test_rec_clock");
+}
@@ -0,0 +1,59 @@
+/*
+ * Packed recording format: every in-range sample survives
+ * record_encode()/record_decode(), out-of-range values clamp to the
+ * field limits, and erased or foreign bytes never decode.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define X_LO(ch, name, rd, norm, bits, bias, led) lo[ch] = -(bias);
+#define X_HI(ch, name, rd, norm, bits, bias, led) hi[ch] = (1 << (bits)) - 1 - (bias);
+
+int main(void) {
+  int32_t lo[CH_COUNT], hi[CH_COUNT];
+  int32_t v[CH_COUNT], out[CH_COUNT];
+  uint8_t b[REC_SIZE + 1];
+  uint32_t seed = 1;
+
+  SENSORS(X_LO)
+  SENSORS(X_HI)
+  CHECK_EQ(REC_SIZE, 6);
+
+  for (int i = 0; i < 100000; i++) {
+    for (int ch = 0; ch < CH_COUNT; ch++) {
+      seed = seed * 1103515245 + 12345;
+      v[ch] = lo[ch] + (int32_t) ((seed >> 8) % (uint32_t) (hi[ch] - lo[ch] + 1));
+    }
+    if (i < 2)
+      for (int ch = 0; ch < CH_COUNT; ch++)
+        v[ch] = i ? hi[ch] : lo[ch];
+
+    b[REC_SIZE] = 0xa5;
+    record_encode(b, v);
+    CHECK_EQ(b[REC_SIZE], 0xa5);
+    CHECK(record_decode(b, out));
+    for (int ch = 0; ch < CH_COUNT; ch++)
+      CHECK_EQ(out[ch], v[ch]);
+  }
+
+  // nadvor od opsegot se zasekuva na granicite
+  for (int ch = 0; ch < CH_COUNT; ch++)
+    v[ch] = hi[ch] + 1000;
+  record_encode(b, v);
+  CHECK(record_decode(b, out));
+  for (int ch = 0; ch < CH_COUNT; ch++)
+    CHECK_EQ(out[ch], hi[ch]);
+  for (int ch = 0; ch < CH_COUNT; ch++)
+    v[ch] = lo[ch] - 1000;
+  record_encode(b, v);
+  CHECK(record_decode(b, out));
+  for (int ch = 0; ch < CH_COUNT; ch++)
+    CHECK_EQ(out[ch], lo[ch]);
+
+  memset(b, 0xff, sizeof(b));
+  CHECK(!record_decode(b, out));
+  memcpy(b, "25010000409", REC_SIZE);
+  CHECK(!record_decode(b, out));
+
+  return check_done("test_record");
+}
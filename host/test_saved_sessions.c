@@ -0,0 +1,128 @@
+/*
+ * Reading back earlier sessions: procitaj(ch, back) walks from the head
+ * session to the ones written before it, so an older recording still
+ * reads whole after newer ones, cut sessions keep their flags, and
+ * there is nothing past the oldest. After the ring has gone round,
+ * every session back to the lap boundary reads with its own values and
+ * the oldest one keeps only its newest pages. SW4 on the saved view
+ * steps back a session at a time and wraps to the newest.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define RING_SESSIONS 60
+
+// sesija od n zapisi so svetlina lux, zatvorena ili ne
+static void record_session(int n, int32_t lux, int commit) {
+  int32_t v[CH_COUNT] = {0};
+
+  store_begin(0);
+  for (int i = 0; i < n; i++) {
+    v[CH_LIGHT] = lux;
+    zapisi(v);
+  }
+  if (commit)
+    store_commit();
+  else
+    fw_run(STORE_FLUSH_MS + EEPROM_WRITE_MS); // zapisite od RAM, bez STORE_COMMIT
+  i2c_sync();
+}
+
+// site zapisi od procitaj() imaat ista svetlina
+static void check_light(int n, int32_t lux) {
+  uint32_t recs = 0;
+
+  for (int x = 0; x < ENV_BUCKETS; x++) {
+    if (env_cols[x].n == 0)
+      continue;
+    CHECK_EQ(env_cols[x].min, normalize_light(lux));
+    CHECK_EQ(env_cols[x].max, normalize_light(lux));
+    recs += env_cols[x].n;
+  }
+  CHECK_EQ(recs, n);
+}
+
+static int ring_len(int s) {
+  return 1 + (s * 37) % REC_COUNT;
+}
+
+int main(void) {
+  fw_boot();
+  i2c_sync();
+  sim_eeprom_erase();
+  store_init();
+  CHECK_EQ(procitaj(CH_LIGHT, 0), 0);
+
+  // tri sesii, srednata presecena
+  record_session(30, 100, 1);
+  record_session(200, 200, 0);
+  record_session(50, 300, 1);
+
+  CHECK_EQ(procitaj(CH_LIGHT, 0), 50);
+  CHECK(saved_committed);
+  check_light(50, 300);
+  CHECK_EQ(procitaj(CH_LIGHT, 1), 200);
+  CHECK(!saved_committed);
+  check_light(200, 200);
+  CHECK_EQ(procitaj(CH_LIGHT, 2), 30);
+  CHECK(saved_committed);
+  check_light(30, 100);
+  CHECK_EQ(window_get( & measures, measures.count - 1), normalize_light(100));
+  CHECK_EQ(procitaj(CH_LIGHT, 3), 0);
+
+  // istoto i po reset
+  store_init();
+  CHECK_EQ(procitaj(CH_LIGHT, 2), 30);
+  check_light(30, 100);
+
+  // SW4 na pregledot: sekoja prethodna, pa pak poslednata
+  mode = MODE_SAVED;
+  sel_ch = CH_LIGHT;
+  ui_state = UI_SENSORS;
+  ui_event(EV_SW4);
+  CHECK_EQ(ui_state, UI_SAVED);
+  CHECK_EQ(saved_back, 0);
+  CHECK_EQ(saved_count, 50);
+  int expect[] = {200, 30, 50};
+  for (int k = 0; k < 3; k++) {
+    ui_event(EV_SW4);
+    oled_wait();
+    CHECK_EQ(ui_state, UI_SAVED);
+    CHECK_EQ(saved_back, (k + 1) % 3);
+    CHECK_EQ(saved_count, expect[k]);
+  }
+  ui_event(EV_SW3);
+  CHECK_EQ(ui_state, UI_MODES);
+
+  // prsten sto pominal pove od eden krug
+  for (int s = 0; s < RING_SESSIONS; s++)
+    record_session(ring_len(s), s, 1);
+  fw_run(EEPROM_WRITE_MS);
+  store_init();
+
+  int back = 0, whole = 0;
+  uint32_t pages = 0;
+  for (;; back++) {
+    int n = procitaj(CH_LIGHT, back);
+    if (n == 0)
+      break;
+    int s = RING_SESSIONS - 1 - back;
+    CHECK(s >= 0);
+    check_light(n, s);
+    if (n == ring_len(s)) {
+      whole++;
+    } else {
+      // najstarata, bez prvite strani
+      CHECK(n < ring_len(s));
+      CHECK_EQ(procitaj(CH_LIGHT, back + 1), 0);
+    }
+    pages += (n + STORE_RECS_PER_PAGE - 1) / STORE_RECS_PER_PAGE;
+  }
+  printf("ring: %d sessions back from the head, %d whole, about %u of %u pages\n", back, whole, pages,
+         STORE_PAGES);
+  CHECK(whole >= back - 1);
+  CHECK(back > 3);
+  CHECK_RANGE(pages, STORE_PAGES - back - 1, STORE_PAGES);
+
+  return check_done("test_saved_sessions");
+}
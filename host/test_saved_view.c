@@ -0,0 +1,153 @@
+/*
+ * The saved view of sessions longer than the 96 columns: procitaj()
+ * streams every record into the envelope and env_render() draws the
+ * whole session in one frame. Every column holds min, max and mean of
+ * a contiguous run of records, the runs cover the session in order and
+ * are even to within a factor of two, and the panel shows each
+ * column's min-max bar. A timed recording of REC_COUNT records goes
+ * through the menus to the same view, and drawing a session of 2000
+ * records costs the same frame and about the same time as drawing it.
+ */
+#include <time.h>
+
+#include "fw.h"
+#include "check.h"
+
+#define LONG_RECS 2000
+#define FULL_FRAME (OLED_PAGES * (3 + OLED_DISPLAY_WIDTH))
+#define RENDER_REPS 50
+
+static int32_t norm[LONG_RECS];
+
+// svetlina so brz i bavan bran, za razlicni min i max vo sekoja kolona
+static uint32_t lux_at(int i) {
+  return 2000 + (i % 17) * 60 - (i / 40 % 2) * 1500;
+}
+
+static void record_session(int n) {
+  int32_t v[CH_COUNT] = {0};
+
+  store_begin(0);
+  for (int i = 0; i < n; i++) {
+    v[CH_LIGHT] = lux_at(i);
+    norm[i] = normalize_light(v[CH_LIGHT]);
+    zapisi(v);
+  }
+  store_commit();
+  i2c_sync();
+}
+
+static void open_saved(void) {
+  mode = MODE_SAVED;
+  sel_ch = CH_LIGHT;
+  start_view();
+  oled_wait();
+  CHECK_EQ(ui_state, UI_SAVED);
+}
+
+// kolonite se posledovatelni parcinja od norm[], po redosled
+static void check_columns(int n) {
+  int i = 0, nmin = n, nmax = 0;
+
+  for (int x = 0; x < OLED_DISPLAY_WIDTH; x++) {
+    env_t * e = & env_cols[x];
+    if (n >= OLED_DISPLAY_WIDTH)
+      CHECK(e->n > 0);
+    if (e->n == 0)
+      continue;
+    int32_t lo = norm[i], hi = norm[i], sum = 0;
+    for (int k = 0; k < e->n && i < n; k++, i++) {
+      lo = norm[i] < lo ? norm[i] : lo;
+      hi = norm[i] > hi ? norm[i] : hi;
+      sum += norm[i];
+    }
+    CHECK_EQ(e->min, lo);
+    CHECK_EQ(e->max, hi);
+    CHECK_EQ(e->sum, sum);
+    nmin = e->n < nmin ? e->n : nmin;
+    nmax = e->n > nmax ? e->n : nmax;
+
+    // stapceto min-max e na panelot
+    CHECK_EQ(sim_oled_pixel(x, 64 - e->max), 0);
+    CHECK_EQ(sim_oled_pixel(x, 64 - e->min), 0);
+  }
+  CHECK_EQ(i, n);
+  CHECK(nmax <= 2 * nmin + 1);
+  CHECK(nmax <= 2 * ((n + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH));
+}
+
+// najbrzoto od RENDER_REPS crtanja od istite kofi, vo ns
+static uint64_t render_ns(void) {
+  static env_t saved[ENV_BUCKETS];
+  uint64_t best = UINT64_MAX;
+
+  memcpy(saved, env_cols, sizeof(saved));
+  for (int r = 0; r < RENDER_REPS; r++) {
+    memcpy(env_cols, saved, sizeof(saved));
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, & t0);
+    env_render("Saved data:");
+    clock_gettime(CLOCK_MONOTONIC, & t1);
+    oled_wait();
+    uint64_t ns = (t1.tv_sec - t0.tv_sec) * 1000000000ull + t1.tv_nsec - t0.tv_nsec;
+    best = ns < best ? ns : best;
+  }
+  return best;
+}
+
+int main(void) {
+  fw_boot();
+  i2c_sync();
+  sim_eeprom_erase();
+  store_init();
+
+  // kratka sesija: eden zapis po kolona, nisto ne se spojuva
+  record_session(100);
+  open_saved();
+  CHECK_EQ(saved_count, 100);
+  CHECK_EQ(env_stride, 1);
+  check_columns(100);
+
+  // dolga sesija, 20 zapisi po kolona
+  record_session(LONG_RECS);
+  open_saved();
+  CHECK_EQ(saved_count, LONG_RECS);
+  CHECK_EQ(window_get( & measures, measures.count - 1), norm[LONG_RECS - 1]);
+  check_columns(LONG_RECS);
+  uint32_t long_bytes = fb_stats.last_frame_bytes;
+  uint32_t long_stride = env_stride;
+  uint64_t long_ns = render_ns();
+
+  // snimanje od menito, REC_COUNT zapisi na 200 ms
+  stop_view();
+  ch7seg = '1';
+  mode = MODE_SAVE;
+  ui_state = UI_CHOOSE_TIME;
+  ui_event(EV_SW4);
+  CHECK_EQ(ui_state, UI_RECORDING);
+  for (int t = 0; ui_state == UI_RECORDING && t < REC_COUNT + 10; t++) {
+    sim.lux = lux_at(t);
+    fw_run(SAMPLE_PERIOD);
+  }
+  CHECK_EQ(ui_state, UI_MODES);
+  open_saved();
+  CHECK_EQ(saved_count, REC_COUNT);
+  CHECK(saved_committed);
+  uint32_t recs = 0;
+  for (int x = 0; x < OLED_DISPLAY_WIDTH; x++) {
+    CHECK(env_cols[x].n > 0);
+    recs += env_cols[x].n;
+  }
+  CHECK_EQ(recs, REC_COUNT);
+  uint32_t rec_bytes = fb_stats.last_frame_bytes;
+  uint64_t rec_ns = render_ns();
+
+  printf("render: %d records %u bytes %u ns (stride %u), %d records %u bytes %u ns (stride %u)\n", REC_COUNT,
+         rec_bytes, (unsigned) rec_ns, REC_COUNT / OLED_DISPLAY_WIDTH, LONG_RECS, long_bytes,
+         (unsigned) long_ns, long_stride);
+  CHECK(rec_bytes <= FULL_FRAME);
+  CHECK(long_bytes <= FULL_FRAME);
+  CHECK(long_ns < 2 * rec_ns + 20000); // ne raste so dolzinata
+
+  return check_done("test_saved_view");
+}
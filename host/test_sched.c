@@ -0,0 +1,67 @@
+/*
+ * Cooperative scheduler on the virtual clock: periodic timers run on
+ * their absolute deadlines, one-shots run once, events are handled in
+ * the same pass, and the firmware's own task set reports its jitter.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define TMR_T1 TMR_COUNT // slobodnite mesta po tajmerite na firmware-ot
+#define TMR_T2 (TMR_COUNT + 1)
+#define TMR_T3 (TMR_COUNT + 2)
+
+static uint32_t t1_at[64], t1_n;
+static uint32_t t2_n, t3_at;
+static uint64_t ev_at;
+
+static void t1(void) {
+  if (t1_n < 64)
+    t1_at[t1_n] = msTicks;
+  t1_n++;
+}
+
+static void t2(void) {
+  t2_n++;
+}
+
+static void t3(void) {
+  t3_at = msTicks;
+  ev_at = sim_now();
+  event_post(EV_SW3); // vo menito samo ja pomestuva izbranata opcija
+}
+
+int main(void) {
+  fw_boot();
+  fw_run(3000);
+
+  // sopstvenite zadaci na firmware-ot
+  for (int i = 0; i < SCHED_TIMERS; i++)
+    if (timers[i].runs > 0)
+      printf("timer %d: period %u ms, %u runs, max late %u ms\n", i, timers[i].period, timers[i].runs,
+             timers[i].max_late);
+  CHECK_RANGE(timers[TMR_SAMPLE].runs, 3000 / SAMPLE_PERIOD, 3000 / SAMPLE_PERIOD + 1);
+  CHECK_EQ(timers[TMR_SAMPLE].max_late, 0);
+  CHECK_RANGE(timers[TMR_DUTY].runs, 3000 / DUTY_PERIOD - 1, 3000 / DUTY_PERIOD);
+
+  // testovite tajmeri pokraj tie na firmware-ot
+  uint32_t t0 = msTicks;
+  timer_start(TMR_T1, t1, 10, 7);
+  timer_start(TMR_T2, t2, 3, 13);
+  timer_start(TMR_T3, t3, 50, 0);
+  fw_run(300);
+
+  CHECK_RANGE(t1_n, 41, 42);
+  for (uint32_t i = 0; i < t1_n && i < 64; i++)
+    CHECK_EQ(t1_at[i] - t0, 10 + 7 * i);
+  CHECK_RANGE(t2_n, 23, 24);
+  CHECK_EQ(t3_at - t0, 50);
+  CHECK_EQ(timers[TMR_T3].runs, 1);
+  CHECK_EQ(timers[TMR_T3].active, 0);
+  CHECK_EQ(timers[TMR_T1].max_late, 0);
+  CHECK_EQ(timers[TMR_T2].max_late, 0);
+  CHECK(ev_head == ev_tail);
+  CHECK_RANGE(timers[TMR_SAMPLE].runs, 3300 / SAMPLE_PERIOD, 3300 / SAMPLE_PERIOD + 1);
+  CHECK(ev_at > 0);
+
+  return check_done("test_sched");
+}
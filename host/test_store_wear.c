@@ -0,0 +1,70 @@
+/*
+ * The recording ring over the whole EEPROM: sessions of mixed length
+ * go round it more than once, every page of the device takes its turn
+ * and the wear stays within one write from page to page.
+ * Capacity, write amplification and the wear spread are printed; the
+ * head found by store_init() is where the writes stopped.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define SESSIONS 60
+
+int main(void) {
+  int32_t v[CH_COUNT] = {0};
+  uint32_t records = 0;
+
+  fw_boot();
+  i2c_sync();
+  sim_eeprom_erase();
+  store_init();
+  memset(sim.eeprom.wear, 0, sizeof(sim.eeprom.wear));
+  uint32_t w0 = sim.eeprom.page_writes;
+
+  for (int s = 0; s < SESSIONS; s++) {
+    int n = 1 + (s * 37) % REC_COUNT;
+    store_begin(0);
+    for (int i = 0; i < n; i++) {
+      v[CH_TEMPERATURE] = 200 + i;
+      v[CH_LIGHT] = s;
+      zapisi(v);
+    }
+    store_commit();
+    records += n;
+  }
+  i2c_sync();
+  fw_run(EEPROM_WRITE_MS);
+
+  uint32_t writes = sim.eeprom.page_writes - w0;
+  uint16_t wmin = 0xffff, wmax = 0;
+  for (int p = 0; p < SIM_EEPROM_PAGES; p++) {
+    if (sim.eeprom.wear[p] < wmin)
+      wmin = sim.eeprom.wear[p];
+    if (sim.eeprom.wear[p] > wmax)
+      wmax = sim.eeprom.wear[p];
+    CHECK_EQ(store.wear[p], sim.eeprom.wear[p]);
+  }
+  printf("capacity %u records on %u pages, %u records in %u page writes, "
+         "write amplification %.2f, wear %u..%u\n",
+         STORE_PAGES * STORE_RECS_PER_PAGE, STORE_PAGES, records, writes,
+         (double) writes * EEPROM_PAGE_SIZE / (records * REC_SIZE), wmin, wmax);
+
+  CHECK_EQ(STORE_PAGES, SIM_EEPROM_PAGES);
+  CHECK(writes > STORE_PAGES); // barem eden krug
+  CHECK(wmin > 0);
+  CHECK(wmax - wmin <= 1); // commit e poseben zapis, ne se prezapisuvaat zapisite
+
+  // povtorno baranje na glavata od EEPROM
+  uint16_t head = store.head, seq = store.seq;
+  uint8_t session = store.session;
+  store_init();
+  CHECK_EQ(store.head, head);
+  CHECK_EQ(store.seq, seq);
+  CHECK_EQ(store.session, session);
+  CHECK(store.committed);
+  CHECK_EQ(procitaj(CH_LIGHT, 0), 1 + ((SESSIONS - 1) * 37) % REC_COUNT);
+  CHECK_EQ(env_cols[0].min, normalize_light(SESSIONS - 1));
+  CHECK_EQ(env_cols[0].max, normalize_light(SESSIONS - 1));
+
+  return check_done("test_store_wear");
+}
@@ -0,0 +1,159 @@
+/*
+ * UART3 telemetry end to end: a burst fills the ring, the packets that
+ * do not fit are dropped whole and counted, the line drains at 115200
+ * baud, and tools/tlm2csv decodes the stream through a pseudo-terminal
+ * with exactly the packets that were sent and the drops as seq gaps.
+ * A damaged packet is skipped and the decoder picks up at the next one.
+ */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+
+#include "fw.h"
+#include "check.h"
+
+// posle main.c, CR0 i CR1 se i registri na SSP
+#include <termios.h>
+
+#define BURST 200
+#define TOOL "build/tlm2csv"
+#define TOOL_ERR "build/test_telemetry.err"
+
+typedef struct {
+  uint32_t rows;
+  uint32_t packets, lost, logs, bad, skipped;
+  int32_t burst_sum;
+} decoded_t;
+
+// pusta go dekoderot na path, ceka rows redovi pa go zatvora master
+static void decode(const char * path, int master, const uint8_t * b, uint32_t len,
+                   uint32_t rows, decoded_t * d) {
+  char cmd[256], line[128];
+  pid_t writer = -1;
+
+  memset(d, 0, sizeof(* d));
+  alarm(30); // dekoder koj ne gi dava site redovi ne go zaglavuva testot
+  snprintf(cmd, sizeof(cmd), TOOL " %s 2>" TOOL_ERR, path);
+  FILE * csv = popen(cmd, "r");
+  CHECK(csv != NULL);
+
+  if (master >= 0) {
+    writer = fork();
+    if (writer == 0) {
+      for (uint32_t off = 0; off < len; ) {
+        ssize_t w = write(master, b + off, len - off);
+        if (w <= 0)
+          _exit(1);
+        off += w;
+      }
+      pause();
+      _exit(0);
+    }
+  }
+
+  fgets(line, sizeof(line), csv); // zaglavie
+  while (fgets(line, sizeof(line), csv)) {
+    unsigned seq, t;
+    char ch[32];
+    int v;
+    d->rows++;
+    if (sscanf(line, "%u,%u,%31[^,],%d", & seq, & t, ch, & v) == 4 && !strcmp(ch, "0x20"))
+      d->burst_sum += v;
+    if (master >= 0 && d->rows == rows) {
+      kill(writer, SIGKILL);
+      waitpid(writer, NULL, 0);
+      close(master); // citanjeto od slave dava EIO, dekoderot zavrsuva
+    }
+  }
+  pclose(csv);
+  alarm(0);
+
+  FILE * err = fopen(TOOL_ERR, "r");
+  CHECK(err != NULL);
+  CHECK_EQ(fscanf(err, "packets %u lost %u logs %u bad %u skipped bytes %u", & d->packets,
+                  & d->lost, & d->logs, & d->bad, & d->skipped), 5);
+  fclose(err);
+}
+
+// prstenot i FIFO na UART3 se prazni, bez novi paketi od glavnata jamka
+static void drain(void) {
+  while (tlm_tail != tlm_head)
+    sim_delay(1000);
+  sim_delay(2000);
+}
+
+int main(void) {
+  decoded_t d;
+  int32_t burst_sum = 0;
+
+  fw_boot();
+  fw_run(2000);
+  CHECK_EQ(tlm_stats.dropped, 0);
+  drain();
+
+  // naplet pobrz od linijata
+  uint32_t packets = tlm_stats.packets;
+  uint32_t len0 = sim.uart.len;
+  for (int i = 0; i < BURST; i++) {
+    uint32_t p = tlm_stats.packets;
+    tlm_send(0x20, i);
+    if (tlm_stats.packets != p)
+      burst_sum += i;
+  }
+  uint32_t queued = tlm_stats.packets - packets;
+  CHECK_RANGE(queued, TLM_RING_SIZE / TLM_PACKET_SIZE, TLM_RING_SIZE / TLM_PACKET_SIZE + 2);
+  CHECK_EQ(tlm_stats.dropped, BURST - queued);
+
+  uint64_t t = sim_now();
+  while (sim.uart.len - len0 < queued * TLM_PACKET_SIZE)
+    sim_delay(100);
+  uint32_t bytes_s = (uint64_t) (sim.uart.len - len0) * 1000000 / (sim_now() - t);
+  printf("burst: %u of %u packets queued, line %u bytes/s\n", queued, BURST, bytes_s);
+  CHECK_RANGE(bytes_s, TLM_BAUD / 10 * 95 / 100, TLM_BAUD / 10);
+
+  fw_run(3000);
+  drain();
+  CHECK_EQ(sim.uart.overruns, 0);
+
+  // preku pseudo-terminal, kako seriska linija
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  CHECK(master >= 0);
+  fcntl(master, F_SETFD, FD_CLOEXEC); // samo ovoj proces go drzi master
+  CHECK_EQ(grantpt(master), 0);
+  CHECK_EQ(unlockpt(master), 0);
+  const char * slave_path = ptsname(master);
+  int slave = open(slave_path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+  struct termios tio;
+  tcgetattr(slave, & tio);
+  cfmakeraw( & tio);
+  tcsetattr(slave, TCSANOW, & tio);
+
+  decode(slave_path, master, sim.uart.out, sim.uart.len, tlm_stats.packets, & d);
+  close(slave);
+  printf("pty: %u rows, %u packets, %u lost, %u logs, %u bytes skipped\n",
+         d.rows, d.packets, d.lost, d.logs, d.skipped);
+  CHECK_EQ(d.rows, tlm_stats.packets);
+  CHECK_EQ(d.packets, tlm_stats.packets);
+  CHECK_EQ(d.lost, tlm_stats.dropped);
+  CHECK_EQ(d.burst_sum, burst_sum);
+  CHECK_EQ(d.bad, 0);
+  CHECK_EQ(d.skipped, 0);
+
+  // osteten paket vo sredinata na datotekata
+  const char * file = "build/test_telemetry.bin";
+  uint8_t * b = malloc(sim.uart.len);
+  memcpy(b, sim.uart.out, sim.uart.len);
+  uint32_t at = len0 + 5 * TLM_PACKET_SIZE + 6;
+  b[at] ^= 0x10;
+  FILE * f = fopen(file, "wb");
+  fwrite(b, 1, sim.uart.len, f);
+  fclose(f);
+  decode(file, -1, NULL, 0, 0, & d);
+  CHECK_EQ(d.packets, tlm_stats.packets - 1);
+  CHECK_EQ(d.lost, tlm_stats.dropped + 1);
+  CHECK(d.bad >= 1);
+  CHECK_EQ(d.skipped, TLM_PACKET_SIZE);
+  free(b);
+
+  return check_done("test_telemetry");
+}
@@ -0,0 +1,53 @@
+/*
+ * MAX6576 period measurement from EINT3 and TIMER3: read_temperature()
+ * costs no virtual time, a measurement tracks the simulated
+ * temperature to 0.1 C, the P0.2 interrupt is only on while one runs,
+ * and SW3 keeps working during a measurement.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define EINT3_IRQS (sim.core.count[EINT3_IRQn + 1])
+
+int main(void) {
+  static const int32_t temps[] = {250, -100, 0, 371, 1200};
+
+  fw_boot();
+  CHECK_RANGE(temp_value, 249, 251);
+
+  for (int i = 0; i < (int) (sizeof(temps) / sizeof(temps[0])); i++) {
+    sim.temp = temps[i];
+    uint64_t t = sim_now();
+    read_temperature();
+    CHECK_EQ(sim_now(), t);
+    CHECK(temp_busy);
+    while (temp_busy)
+      sim_delay(1000);
+    printf("temp %d: measured %d in %u ms\n", temps[i], temp_value, (uint32_t) (sim_now() - t) / 1000);
+    CHECK_RANGE(temp_value, temps[i] - 1, temps[i] + 1);
+    CHECK_RANGE(sim_now() - t, (uint64_t) TEMP_PERIODS * (TEMP_ZERO_US + temps[i]),
+                (uint64_t) (TEMP_PERIODS + 1) * (TEMP_ZERO_US + temps[i]) + 1000);
+  }
+
+  // bez merenje P0.2 ne prekinuva
+  uint32_t irqs = EINT3_IRQS;
+  sim_delay(100000);
+  CHECK_EQ(EINT3_IRQS, irqs);
+
+  // SW3 za vreme na merenjeto
+  read_temperature();
+  fw_press(3, 100);
+  sim_delay(200000);
+  CHECK_EQ(event_get(), EV_SW3);
+  CHECK(!temp_busy);
+
+  // glavnata jamka: sekoj primerok ja dava temperaturata od prethodnoto merenje
+  sim.temp = 300;
+  fw_run(SAMPLE_PERIOD);
+  timers[TMR_SAMPLE].max_late = 0;
+  fw_run(1000);
+  CHECK_RANGE(raw_latest[CH_TEMPERATURE], 299, 301);
+  CHECK_EQ(timers[TMR_SAMPLE].max_late, 0);
+
+  return check_done("test_temp");
+}
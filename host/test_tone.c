@@ -0,0 +1,62 @@
+/*
+ * Background song playback: playSong() returns without using any
+ * virtual time, TIMER2 toggles P0.26 at the note's rate, the song runs
+ * to its end with the pin low, and the sampling task keeps the same
+ * cadence as without a song.
+ */
+#include "fw.h"
+#include "check.h"
+
+#define TONE_IRQS (sim.core.count[TIMER2_IRQn + 1])
+
+static uint8_t tune[] = "C5,E5,G5.";
+
+int main(void) {
+  uint32_t runs0, runs1, song_ms = 0;
+  uint32_t note_us = getNote(tune[0]) / 2 + 1;
+
+  fw_boot();
+  fw_run(1000);
+
+  // bez pesna
+  runs0 = timers[TMR_SAMPLE].runs;
+  fw_run(3000);
+  runs0 = timers[TMR_SAMPLE].runs - runs0;
+
+  // so pesna, ist interval
+  uint64_t t = sim_now();
+  runs1 = timers[TMR_SAMPLE].runs;
+  playSong(tune);
+  CHECK_EQ(sim_now(), t);
+  CHECK(song_pos != NULL);
+
+  // prvata nota, po eden prekin na sekoja polovina perioda
+  uint32_t irqs = TONE_IRQS;
+  while (TONE_IRQS == irqs)
+    fw_run(1);
+  uint64_t t1 = sim_now();
+  irqs = TONE_IRQS;
+  fw_run_until(t1 + 100000);
+  uint32_t toggles = TONE_IRQS - irqs;
+  uint32_t expect = (uint32_t) (sim_now() - t1) / note_us;
+  CHECK_RANGE(toggles, expect - 2, expect + 2);
+
+  fw_run_until(t + 3000000);
+  runs1 = timers[TMR_SAMPLE].runs - runs1;
+  while (song_pos != NULL && sim_now() < t + 20000000)
+    fw_run(10);
+
+  for (int i = 0; tune[i] != '\0' && tune[i + 1] != '\0'; i += 3)
+    song_ms += getDuration(tune[i + 1]) + getPause(tune[i + 2]);
+  printf("song: %u ms (written %u ms), sampling %u runs vs %u without\n",
+         (uint32_t) (sim_now() - t) / 1000, song_ms, runs1, runs0);
+
+  CHECK(song_pos == NULL);
+  CHECK_RANGE(sim_now() - t, (uint64_t) song_ms * 1000, (uint64_t) song_ms * 1000 + 10000);
+  CHECK_EQ(sim_pin(0, 26), 0);
+  CHECK_EQ(LPC_TIM2->TCR & 1, 0);
+  CHECK_RANGE(runs1, runs0 - 1, runs0 + 1);
+  CHECK_EQ(sim.core.storms, 0);
+
+  return check_done("test_tone");
+}
@@ -0,0 +1,38 @@
+/*
+ * sample_window_t reads back in the same order as the shift-by-one
+ * arrays it replaced, before and after it wraps.
+ */
+#include "fw.h"
+#include "check.h"
+
+int main(void) {
+  sample_window_t w;
+  int32_t ref[WINDOW_DEPTH];
+  int n = 0;
+
+  window_clear( & w);
+  CHECK_EQ(w.count, 0);
+  for (int i = 0; i < 5 * WINDOW_DEPTH + 3; i++) {
+    int32_t v = i * 7 - 40;
+
+    window_push( & w, v);
+    if (n < WINDOW_DEPTH) {
+      ref[n++] = v;
+    } else {
+      for (int k = 0; k < WINDOW_DEPTH - 1; k++)
+        ref[k] = ref[k + 1];
+      ref[WINDOW_DEPTH - 1] = v;
+    }
+
+    CHECK_EQ(w.count, n);
+    for (int k = 0; k < n; k++)
+      CHECK_EQ(window_get( & w, k), ref[k]);
+  }
+
+  window_clear( & w);
+  window_push( & w, 9);
+  CHECK_EQ(w.count, 1);
+  CHECK_EQ(window_get( & w, 0), 9);
+
+  return check_done("test_window");
+}
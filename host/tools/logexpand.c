@@ -0,0 +1,119 @@
+/*
+ * Log records from the UART3 stream back to text.
+ *
+ *   logexpand [stream]    stream is a file, a serial port or a
+ *                         pseudo-terminal, stdin without one
+ *
+ * The board sends only a log ID and its integer arguments; the format
+ * strings live here, in the order of the LOG_* enum in src/main.c.
+ * A %s argument is an index into the name table given for it. Each
+ * record prints as "t_ms: text". Telemetry packets on the same line are
+ * passed over, the counts go to stderr at the end.
+ */
+#include <stdlib.h>
+
+#include "stream.h"
+
+static const char * const units[] = {"cycles", "ns", NULL};
+static const char * const scopes[] = {"sensors", "normalize", "draw", "flush", "leds", "eeprom", NULL};
+
+typedef struct {
+  const char * fmt;
+  const char * const * names[LOG_MAX_ARGS]; // za %s, po redosled na argumentite
+} log_fmt_t;
+
+static const log_fmt_t fmts[] = {
+  { "ch7seg++: %d" }, // LOG_CH7SEG
+  { "recorded %d records, %d page writes" }, // LOG_RECORD_DONE
+  { "scope count min avg max (%s)", { units } }, // LOG_PROF_HEADER
+  { "%s %u %u %u %u", { scopes } }, // LOG_PROF_STAT
+  { "@%u %s %u", { NULL, scopes } }, // LOG_PROF_TRACE
+  { "session %u head %u record bytes %u page writes %u" }, // LOG_STORE
+  { "recovered head %u seq %u session %u committed %u" }, // LOG_STORE_RECOVER
+  { "capture %u samples %u skipped %u failed %u overruns %u lost" }, // LOG_CAPTURE
+  { "active %u sleep %u ticks, %u wakeups" }, // LOG_IDLE
+  { "period %u us late max %u avg %u us missed %u dropped %u" } // LOG_REC_CLOCK
+};
+
+#define FMT_COUNT (sizeof(fmts) / sizeof(fmts[0]))
+
+static const char * name_of(const char * const * names, int32_t i) {
+  for (int k = 0; names[k]; k++)
+    if (k == i)
+      return names[k];
+  return NULL;
+}
+
+// printf so argumentite od zapisot, fali li argument se pecati "?"
+static void expand(const frame_t * f) {
+  const log_fmt_t * lf = & fmts[f->ch];
+  int a = 0;
+
+  for (const char * p = lf->fmt; * p; p++) {
+    if (* p != '%' || p[1] == '\0') {
+      putchar(* p);
+      continue;
+    }
+    p++;
+    if (* p == '%') {
+      putchar('%');
+      continue;
+    }
+    if (a >= f->n) {
+      putchar('?');
+      continue;
+    }
+    const char * name = NULL;
+    if (* p == 's' && lf->names[a])
+      name = name_of(lf->names[a], f->v[a]);
+    if (name)
+      fputs(name, stdout);
+    else if (* p == 'u' || * p == 's')
+      printf("%u", (uint32_t) f->v[a]);
+    else
+      printf("%d", f->v[a]);
+    a++;
+  }
+}
+
+int main(int argc, char ** argv) {
+  stream_t s;
+  frame_t f;
+  uint32_t records = 0, unknown = 0, packets = 0;
+
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [stream]\n", argv[0]);
+    return 2;
+  }
+  if (stream_open( & s, argc > 1 ? argv[1] : NULL) < 0) {
+    perror(argv[1]);
+    return 2;
+  }
+
+  for (;;) {
+    int type = stream_next( & s, & f);
+    if (type == FRAME_END)
+      break;
+    if (type == FRAME_TLM) {
+      packets++;
+      continue;
+    }
+
+    records++;
+    printf("%u: ", f.at);
+    if (f.ch < FMT_COUNT) {
+      expand( & f);
+    } else {
+      unknown++;
+      printf("log id %u:", f.ch);
+      for (int a = 0; a < f.n; a++)
+        printf(" %d", f.v[a]);
+    }
+    putchar('\n');
+    fflush(stdout);
+  }
+
+  fprintf(stderr, "records %u unknown %u packets %u bad %u skipped bytes %u\n",
+          records, unknown, packets, s.bad, s.skipped);
+  return unknown || s.skipped ? 1 : 0;
+}
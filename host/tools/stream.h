@@ -0,0 +1,146 @@
+/*
+ * Framing of the UART3 stream, shared by the host tools. Telemetry
+ * packets and log records are interleaved on the same line:
+ *
+ *   0xa5 seq ch t0 t1 t2 t3 v0 v1 v2 v3 sum     (telemetry, 12 bytes)
+ *   0x5a id n t0 t1 t2 t3 a0.. an-1 sum         (log, 8 + 4n bytes)
+ *
+ * Both end with a byte that makes the 8-bit sum after the sync byte
+ * zero. stream_next() returns the next frame that checks out and skips
+ * anything else one byte at a time, so the reader resynchronises after
+ * line noise or a tool started in the middle of a packet.
+ */
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define TLM_SYNC 0xa5
+#define TLM_PACKET_SIZE 12
+#define LOG_SYNC 0x5a
+#define LOG_MAX_ARGS 5
+#define FRAME_MAX (8 + LOG_MAX_ARGS * 4)
+
+enum {
+  FRAME_END,
+  FRAME_TLM,
+  FRAME_LOG
+};
+
+typedef struct {
+  int fd;
+  uint8_t buf[4096];
+  int pos;
+  int len;
+  int eof;
+  uint32_t skipped; // bajti bez vazecka ramka
+  uint32_t bad; // ramki so pogresna suma
+} stream_t;
+
+typedef struct {
+  uint8_t type;
+  uint8_t seq; // TLM
+  uint8_t ch; // TLM kanal ili LOG id
+  uint8_t n; // broj na argumenti
+  uint32_t at; // msTicks
+  int32_t v[LOG_MAX_ARGS];
+} frame_t;
+
+static uint32_t get32(const uint8_t * p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+// seriska linija ili pseudo-terminal: surovi bajti na brzinata na plocata
+static int stream_open(stream_t * s, const char * path) {
+  struct termios t;
+
+  memset(s, 0, sizeof(* s));
+  s->fd = path ? open(path, O_RDONLY | O_NOCTTY) : 0;
+  if (s->fd < 0)
+    return -1;
+  if (isatty(s->fd) && tcgetattr(s->fd, & t) == 0) {
+    cfmakeraw( & t);
+    cfsetspeed( & t, B115200);
+    tcsetattr(s->fd, TCSANOW, & t);
+  }
+  return 0;
+}
+
+// barem need bajti vo baferot, 0 na krajot na vlezot
+static int stream_fill(stream_t * s, int need) {
+  while (s->len - s->pos < need && !s->eof) {
+    if (s->pos > 0) {
+      memmove(s->buf, s->buf + s->pos, s->len - s->pos);
+      s->len -= s->pos;
+      s->pos = 0;
+    }
+    ssize_t r = read(s->fd, s->buf + s->len, sizeof(s->buf) - s->len);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      s->eof = 1; // EIO koga pseudo-terminalot e zatvoren
+    else
+      s->len += r;
+  }
+  return s->len - s->pos >= need;
+}
+
+static int stream_sum(const uint8_t * p, int len) {
+  uint8_t sum = 0;
+
+  for (int i = 1; i < len; i++)
+    sum += p[i];
+  return sum == 0;
+}
+
+static int stream_next(stream_t * s, frame_t * f) {
+  for (;;) {
+    if (!stream_fill(s, 1))
+      return FRAME_END;
+
+    uint8_t * p = s->buf + s->pos;
+    int len = 0;
+    if (p[0] == TLM_SYNC)
+      len = TLM_PACKET_SIZE;
+    else if (p[0] == LOG_SYNC && stream_fill(s, 3)) {
+      p = s->buf + s->pos;
+      if (p[2] <= LOG_MAX_ARGS)
+        len = 8 + p[2] * 4;
+    }
+
+    if (len > 0 && stream_fill(s, len)) {
+      p = s->buf + s->pos;
+      if (stream_sum(p, len)) {
+        s->pos += len;
+        memset(f, 0, sizeof(* f));
+        if (p[0] == TLM_SYNC) {
+          f->type = FRAME_TLM;
+          f->seq = p[1];
+          f->ch = p[2];
+          f->at = get32(p + 3);
+          f->v[0] = get32(p + 7);
+          f->n = 1;
+        } else {
+          f->type = FRAME_LOG;
+          f->ch = p[1];
+          f->n = p[2];
+          f->at = get32(p + 3);
+          for (int a = 0; a < f->n; a++)
+            f->v[a] = get32(p + 7 + a * 4);
+        }
+        return f->type;
+      }
+      s->bad++;
+    }
+    s->pos++;
+    s->skipped++;
+  }
+}
+
+#endif
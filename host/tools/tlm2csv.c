@@ -0,0 +1,72 @@
+/*
+ * Telemetry stream to CSV.
+ *
+ *   tlm2csv [stream]      stream is a file, a serial port or a
+ *                         pseudo-terminal, stdin without one
+ *
+ * Prints one line per telemetry packet, "seq,t_ms,channel,value", and
+ * at the end a summary on stderr: packets, packets lost (gaps in seq),
+ * log records passed over and bytes that were not part of a frame.
+ * The exit status is 1 if anything was lost or damaged.
+ */
+#include <stdlib.h>
+
+#include "stream.h"
+
+static const char * channel_name(uint8_t ch) {
+  static const char * sensors[] = {"Temperature", "Light", "Potentiometer", "Acceleration"};
+
+  if (ch < sizeof(sensors) / sizeof(sensors[0]))
+    return sensors[ch];
+  switch (ch) {
+    case 0x10: return "Record";
+    case 0x11: return "Replay";
+    case 0x12: return "Duty";
+  }
+  return NULL;
+}
+
+int main(int argc, char ** argv) {
+  stream_t s;
+  frame_t f;
+  uint32_t packets = 0, lost = 0, logs = 0;
+  int have_seq = 0;
+  uint8_t seq = 0;
+
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [stream]\n", argv[0]);
+    return 2;
+  }
+  if (stream_open( & s, argc > 1 ? argv[1] : NULL) < 0) {
+    perror(argv[1]);
+    return 2;
+  }
+
+  printf("seq,t_ms,channel,value\n");
+  for (;;) {
+    int type = stream_next( & s, & f);
+    if (type == FRAME_END)
+      break;
+    if (type == FRAME_LOG) {
+      logs++;
+      continue;
+    }
+
+    if (have_seq)
+      lost += (uint8_t) (f.seq - seq - 1);
+    seq = f.seq;
+    have_seq = 1;
+    packets++;
+
+    const char * name = channel_name(f.ch);
+    if (name)
+      printf("%u,%u,%s,%d\n", f.seq, f.at, name, f.v[0]);
+    else
+      printf("%u,%u,0x%02x,%d\n", f.seq, f.at, f.ch, f.v[0]);
+    fflush(stdout);
+  }
+
+  fprintf(stderr, "packets %u lost %u logs %u bad %u skipped bytes %u\n",
+          packets, lost, logs, s.bad, s.skipped);
+  return lost || s.skipped ? 1 : 0;
+}
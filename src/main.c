@@ -8,366 +8,2606 @@
  *
  ******************************************************************************/
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "lpc17xx_pinsel.h"
 #include "lpc17xx_i2c.h"
 #include "lpc17xx_gpio.h"
 #include "lpc17xx_ssp.h"
 #include "lpc17xx_adc.h"
 #include "lpc17xx_timer.h"
+#include "lpc17xx_gpdma.h"
+#include "lpc17xx_uart.h"
 
 #include "light.h"
 #include "oled.h"
-#include "temp.h"
 #include "acc.h"
 #include "led7seg.h"
+#include "eeprom.h"
+#include "pca9532.h"
 
 #define NOTE_PIN_HIGH() GPIO_SetValue(0, 1 << 26);
 #define NOTE_PIN_LOW() GPIO_ClearValue(0, 1 << 26);
 
-uint32_t msTicks = 0;
+#define ADC_SAMPLE_RATE 2000
+#define ADC_RING_SIZE 64 // mora da e stepen na 2
+#define ADC_DMA_CH 1
+#define ADC_DMA_REGS LPC_GPDMACH1
+#define ADC_AVERAGE 16 // konverzii vo edno citanje na potenciometarot
+
+#define TEMP_PIN 2 // P0.2, izlezot na MAX6576
+#define TEMP_PERIODS 32 // periodi vo edno merenje, okolu 100 ms
+#define TEMP_ZERO_US 2731 // perioda na 0 C, 10 us po K
+
+#define NORM_Q 20
+#define Q_CONST(num, den) ((int32_t)((((int64_t)(num) << NORM_Q) + (den) / 2) / (den)))
+#define GRAPH_BASE Q_CONST(10, 1)
+#define TEMP_GAIN Q_CONST(43, 200)
+#define TEMP_OFFSET (GRAPH_BASE - Q_CONST(15 * 43, 20))
+#define LIGHT_GAIN Q_CONST(43, 4000)
+#define POT_GAIN Q_CONST(43, 4095)
+#define ACC_GAIN Q_CONST(43, 256)
+
+/*
+ * Sensor registry, one X() entry per channel:
+ *
+ *   X(channel, name, read, normalize, record bits, record bias, LED shift)
+ *
+ * The acquisition, recording and LED code is expanded from this list,
+ * so every channel gets direct calls instead of going through a table
+ * of function pointers. The LED shift places the 8-LED bar on the
+ * PCA9532 (LED_NONE - no bar).
+ */
+#define SENSORS(X) \
+  X(CH_TEMPERATURE, "Temperature", read_temperature, normalize_temperature, 12, REC_TEMP_OFFSET, 0) \
+  X(CH_LIGHT, "Light", read_light, normalize_light, 12, 0, 8) \
+  X(CH_POTENTIOMETER, "Potentiometer", read_potentiometer, normalize_potentiometer, 12, 0, LED_NONE) \
+  X(CH_ACCELERATION, "Acceleration", read_acceleration, normalize_acceleration, 8, 128, LED_NONE)
+
+#define LED_NONE (-1)
+#define X_BITS(ch, name, rd, norm, bits, bias, led) + (bits)
+
+#define REC_VERSION 2
+#define REC_BITS (4 SENSORS(X_BITS)) // verzija + polinjata
+#define REC_SIZE ((REC_BITS + 7) / 8)
+#ifndef REC_COUNT
+#define REC_COUNT 480 // zapisi vo edno snimanje, pet ekrani od po 96 koloni
+#endif
+#define REC_QUEUE_SIZE 8 // mora da e stepen na 2
+#define REC_TEMP_OFFSET 400 // -40.0 C
+
+#define EEPROM_SIZE 16384
+#define EEPROM_PAGE_SIZE 64
+
+/*
+ * Recording log. The whole EEPROM is a ring of pages that are written
+ * strictly in order. A page starts with a header that has its own CRC
+ * and is followed by chunks of records:
+ *
+ *   seq (2 bytes) session info crc (2 bytes)
+ *   flags|n records... crc (2 bytes)
+ *
+ * seq grows by one per page. Each chunk is appended with one write and
+ * never written again; its CRC-16/CCITT covers the page's seq and the
+ * chunk, so erased bytes, torn writes and chunks left over from the
+ * previous lap never check out. The last chunk of a finished session
+ * carries STORE_COMMIT. info keeps the recording period, so a session
+ * cut by a reset can be resumed. A session always starts on a fresh
+ * page.
+ */
+#define STORE_PAGES (EEPROM_SIZE / EEPROM_PAGE_SIZE)
+#define STORE_HEADER_SIZE 6
+#define STORE_CHUNK_SIZE(n) (1 + (n) * REC_SIZE + 2)
+#define STORE_RECS_PER_PAGE ((EEPROM_PAGE_SIZE - STORE_HEADER_SIZE - STORE_CHUNK_SIZE(0)) / REC_SIZE)
+#define STORE_COMMIT 0x80
+#define STORE_COUNT_MASK 0x3f
+#define STORE_PERIOD_MASK 0x0f // info: indeks vo rec_periods[]
+#define STORE_NO_PERIOD 0x0f // snimanje od capture, ne prodolzuva
+#define STORE_RESUMED 0x10 // info: strana zapisana po reset
+#define STORE_FLUSH_MS 1000 // najdolgo sto zapis ceka vo RAM
+#define EEPROM_WRITE_MS 5 // vreme za zapis na edna strana
+
+/*
+ * I2C2 devices on the base board, accessed directly by the
+ * asynchronous transaction queue.
+ */
+#define I2C_QUEUE_SIZE 8 // mora da e stepen na 2
+#define I2C_MAX_TX (EEPROM_PAGE_SIZE + 2)
+#define I2C_MAX_RX 4
+#define EEPROM_I2C_ADDR 0x50
+#define PCA9532_I2C_ADDR 0x60
+#define PCA9532_LS0_AUTO_INC 0x16
+#define LIGHT_I2C_ADDR 0x44
+#define LIGHT_REG_LSB 0x04
+#define LIGHT_REG_MSB 0x05
+#define LIGHT_RANGE 4000
+#define ACC_I2C_ADDR 0x1d
+#define ACC_REG_XOUT8 0x06
+#define ACC_REG_ZOUT8 0x08
+#define ACC_REG_STATUS 0x09
+#define ACC_REG_CTL1 0x18
+#define ACC_STATUS_DOVR 0x02 // senzorot prepisal neprocitan primerok
+#define ACC_CTL1_DFBW 0x80 // 125 Hz propusen opseg, 250 Hz izlez
+#define ACC_LSB_PER_G 64 // opseg 2g, 8 bita
+
+/*
+ * Vibration capture. TIMER1 runs at the 250 Hz output rate of the
+ * MMA7455 and queues one burst read of XOUT8..STATUS per period.
+ */
+#define CAP_PERIOD_US 4000
+#define CAP_BURST 4 // X, Y, Z, STATUS
+#define CAP_BUF_SIZE 512 // mora da e stepen na 2
+#define CAP_SHOW_PERIOD 100 // ms, osvezuvanje i eden zapis pri snimanje
+
+/*
+ * The OLED panel is an SSD1305 with 132 columns, of which the 96
+ * visible ones start at OLED_X_OFFSET. Chip select and data/command
+ * pins are the same ones the oled driver uses.
+ */
+#define OLED_PAGES (OLED_DISPLAY_HEIGHT / 8)
+#define OLED_X_OFFSET 18
+#define OLED_CS_ON() GPIO_ClearValue(0, 1 << 6)
+#define OLED_CS_OFF() GPIO_SetValue(0, 1 << 6)
+#define OLED_CMD() GPIO_ClearValue(2, 1 << 7)
+#define OLED_DATA() GPIO_SetValue(2, 1 << 7)
+#ifndef OLED_USE_DMA
+#define OLED_USE_DMA 1 // 0 = polled SSP, za sporedba
+#endif
+#define OLED_DMA_CH 0
+#define OLED_RX_DMA_CH 2 // gi prazni primenite bajti, negoviot kraj e krajot na segmentot
+#define OLED_SEGMENTS (2 * OLED_PAGES) // komanda + podatoci za sekoja strana
+
+#define SAMPLE_PERIOD 200 // ms
+#define LED_PERIOD 100
+#define DEBOUNCE_MS 20
+#define LONG_PRESS_MS 1000
+
+#define SCHED_SPARE 3 // slobodni mesta po TMR_COUNT, za testovite
+#ifndef IDLE_WFI
+#define IDLE_WFI 1 // 0 = prazen ciklus namesto spienje, za sporedba
+#endif
+#define DUTY_PERIOD 1000 // ms, telemetrija za aktivnoto vreme
+#define EVENT_QUEUE_SIZE 16 // mora da e stepen na 2
+
+#define TELEMETRY 1 // 0 = bez UART izlez
+#define TLM_BAUD 115200
+#define TLM_RING_SIZE 256 // mora da e stepen na 2
+#define TLM_SYNC 0xa5
+#define TLM_PACKET_SIZE 12
+
+#define LOG_RING_SIZE 32 // mora da e stepen na 2
+#define LOG_MAX_ARGS 5
+#define LOG_SYNC 0x5a
+
+#ifndef PROFILE
+#define PROFILE 0 // 1 = merenje na vremeto na delovite od ciklusot
+#endif
+#define PROF_TRACE_SIZE 64 // mora da e stepen na 2
+#define PROF_DUMP_TRACE 16 // da se sobere vo log baferot
+
+#define LED_BAR_LEVELS 9 // 0..8 svetnati LED
+#define MENU_Y 17
+#define MENU_ROW(i, n) (MENU_Y + (i) * (44 / (n)))
+
+#define WINDOW_DEPTH 13 // broj na tocki na grafikot
+#define ENV_BUCKETS (2 * OLED_DISPLAY_WIDTH) // kofi za pregledot na snimanjeto
+#define GRAPH_STEP (OLED_DISPLAY_WIDTH / (WINDOW_DEPTH - 1))
+
+typedef void (*i2c_done_fn)(uint8_t * rx, int ok);
+
+// edna transakcija, podatocite za prakjanje se kopiraat vo nea
+typedef struct {
+  uint8_t addr;
+  uint8_t tx_len;
+  uint8_t rx_len;
+  uint8_t tx[I2C_MAX_TX];
+  uint8_t rx[I2C_MAX_RX];
+  i2c_done_fn done;
+} i2c_job_t;
+
+typedef struct {
+  uint32_t jobs;
+  uint32_t failed;
+  uint32_t dropped; // redicata bila polna
+  uint32_t bytes; // bajti na magistralata, za iskoristenost
+  uint8_t depth_max;
+} i2c_stats_t;
+
+typedef struct {
+  uint8_t page[EEPROM_PAGE_SIZE]; // strana head kako na EEPROM, so zapisite sto cekaat
+  uint16_t head; // posledna zapisana strana
+  uint16_t seq; // seq na strana head
+  uint8_t session;
+  uint8_t info; // period i STORE_RESUMED za novite strani
+  uint8_t empty; // nitu edna strana ne e zapisana
+  uint8_t open; // page[] e strana head
+  uint8_t fill; // bajti od head na EEPROM, 0 = ni zaglavieto
+  uint8_t pending; // zapisi vo page[] sto ne se zapisani
+  uint16_t session_recs;
+  uint8_t committed; // poslednata sesija zavrsila uredno
+  uint8_t resume; // poslednata sesija e prekinata i moze da prodolzi
+  uint32_t page_writes;
+  uint32_t record_bytes; // za write amplification = page_writes * 64 / record_bytes
+  uint16_t wear[STORE_PAGES]; // zapisi po strana od startot
+} store_t;
+
+/*
+ * Recording clock on TIMER0. The counter runs freely in microseconds
+ * and MR0 is always set to the next absolute deadline, so the period
+ * never accumulates the time spent sampling or writing.
+ */
+typedef struct {
+  uint32_t period_us;
+  uint32_t deadline; // TC na sledniot zapis
+  uint32_t samples;
+  uint32_t late_max; // us od rokot do prekinot
+  uint32_t late_sum;
+  uint32_t missed; // rokovi koi pominale bez zapis
+  uint32_t dropped; // redicata kon EEPROM bila polna
+  uint8_t depth_max;
+  uint8_t running;
+  uint16_t count; // zapisi vo ovaa sesija
+} rec_clock_t;
+
+typedef struct {
+  int8_t x;
+  int8_t y;
+  int8_t z;
+} acc_sample_t;
+
+// sekoj brojac go menuva samo eden prekin
+typedef struct {
+  uint32_t samples;
+  uint32_t skipped; // TIMER1: prethodnoto citanje ne zavrsilo ili redicata bila polna
+  uint32_t failed; // I2C2: citanjeto ne uspealo
+  uint32_t overruns; // DOVR, senzorot dal primerok koj ne e procitan
+  uint32_t lost; // prepisani vo cap_buf pred da se obrabotat
+  uint32_t rate; // primeroci vo poslednata sekunda
+  uint32_t mag; // mg
+  uint32_t peak; // mg
+} cap_stats_t;
+
+/*
+ * Duty cycle, sampled by SysTick: every tick is counted as active or
+ * as sleep depending on where it found the CPU.
+ */
+typedef struct {
+  uint32_t active_ticks;
+  uint32_t sleep_ticks;
+  uint32_t wakeups; // WFI povici
+} idle_stats_t;
+
+typedef struct {
+  uint32_t led_writes;
+  uint32_t led_skipped; // istata sostojba, bez I2C
+  uint32_t seg_writes;
+  uint32_t seg_skipped;
+} out_stats_t;
+
+typedef struct {
+  uint32_t frames;
+  uint32_t bytes; // vkupno bajti prateni na displejot
+  uint32_t last_frame_bytes;
+  uint32_t xfer_us; // trajanje na posledniot prenos
+  uint32_t xfer_us_max;
+  uint32_t xfer_us_sum; // za prosekot po frame
+  uint32_t cpu_busy_us; // vreme vo koe CPU cekal na SSP
+  uint32_t dma_errors;
+} fb_stats_t;
+
+// eden DMA prenos so ista vrednost na D/C linijata
+typedef struct {
+  const uint8_t * data;
+  uint8_t len;
+  uint8_t dc;
+} oled_seg_t;
+
+/*
+ * Software timer, run from the main loop by sched_run(). Deadlines are
+ * absolute, so a late run does not push the following ones back.
+ * period 0 means one-shot.
+ */
+typedef void (*task_fn)(void);
+
+typedef struct {
+  task_fn fn;
+  uint32_t due;
+  uint32_t period;
+  uint8_t active;
+  uint32_t runs;
+  uint32_t max_late; // najgolemo docnenje vo ms (jitter)
+} sw_timer_t;
+
+enum {
+  TMR_SAMPLE,
+  TMR_LEDS,
+  TMR_SONG,
+  TMR_CAPTURE,
+  TMR_DUTY,
+  TMR_STORE,
+  TMR_COUNT
+};
+
+#define SCHED_TIMERS (TMR_COUNT + SCHED_SPARE)
+
+// kanali vo zaednickata istorija na merenja
+#define X_ENUM(ch, name, rd, norm, bits, bias, led) ch,
+enum {
+  SENSORS(X_ENUM)
+  CH_COUNT
+};
+
+// kanal vo telemetrijskiot paket, merenjata go koristat CH_*
+enum {
+  TLM_RECORD = 0x10, // vrednost = broj na zapis
+  TLM_REPLAY = 0x11, // vrednost = procitan normaliziran zapis
+  TLM_DUTY = 0x12 // vrednost = aktivno vreme vo promili od poslednata sekunda
+};
+
+/*
+ * Log messages. Only the ID and the integer arguments leave the board,
+ * the host side expands them with these format strings.
+ */
+enum {
+  LOG_CH7SEG, // "ch7seg++: %d"
+  LOG_RECORD_DONE, // "recorded %d records, %d page writes"
+  LOG_PROF_HEADER, // "scope count min avg max (%s)" 0 = cycles, 1 = ns
+  LOG_PROF_STAT, // "%s %u %u %u %u" scope, count, min, avg, max
+  LOG_PROF_TRACE, // "@%u %s %u" at, scope, ticks
+  LOG_STORE, // "session %u head %u record bytes %u page writes %u"
+  LOG_STORE_RECOVER, // "recovered head %u seq %u session %u committed %u"
+  LOG_CAPTURE, // "capture %u samples %u skipped %u failed %u overruns %u lost"
+  LOG_IDLE, // "active %u sleep %u ticks, %u wakeups"
+  LOG_REC_CLOCK, // "period %u us late max %u avg %u us missed %u dropped %u"
+  LOG_COUNT // host/tools/logexpand.c gi ima formatite po ovoj redosled
+};
+
+// seq se zapisuva posleden, dotogas zapisot ne e gotov
+typedef struct {
+  volatile uint32_t seq;
+  uint32_t at;
+  uint8_t id;
+  uint8_t n;
+  int32_t args[LOG_MAX_ARGS];
+} log_entry_t;
+
+typedef struct {
+  uint32_t written;
+  volatile uint32_t dropped;
+} log_stats_t;
+
+// delovi od kodot sto se merat so PROF_BEGIN / PROF_END
+enum {
+  PRF_SENSORS,
+  PRF_NORMALIZE,
+  PRF_DRAW,
+  PRF_FLUSH,
+  PRF_LEDS,
+  PRF_EEPROM,
+  PRF_COUNT
+};
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} prof_stat_t;
+
+typedef struct {
+  uint8_t scope;
+  uint32_t at; // msTicks
+  uint32_t ticks;
+} prof_trace_t;
+
+typedef struct {
+  uint32_t packets;
+  uint32_t dropped; // nemalo mesto vo baferot
+  uint8_t seq;
+} tlm_stats_t;
+
+enum {
+  EV_NONE,
+  EV_SW3, // SW3 - sledna opcija / nazad
+  EV_SW4, // SW4 - potvrdi
+  EV_SW3_LONG, // dolgo SW3 - nazad vo glavnoto meni
+  EV_SW4_LONG, // dolgo SW4 - izvestaj od profiliranjeto
+  EV_RECORD_DONE,
+  EV_RECORD_SAMPLE // TIMER0 dodal zapis vo rec_q
+};
+
+enum {
+  UI_MODES,
+  UI_SENSORS,
+  UI_REALTIME,
+  UI_CHOOSE_TIME,
+  UI_RECORDING,
+  UI_SAVED,
+  UI_CAPTURE
+};
+
+enum {
+  MODE_REALTIME,
+  MODE_SAVE,
+  MODE_SAVED,
+  MODE_CAPTURE,
+  MODE_COUNT
+};
+
+/*
+ * Debounced push button (active low). An edge only records its time,
+ * the level is accepted once it has been stable for DEBOUNCE_MS. A
+ * button with a long-press event reports the short press on release,
+ * and only if the long press was not sent.
+ */
+typedef struct {
+  uint8_t raw; // posledno procitano nivo
+  uint8_t stable; // 1 - pusteno, 0 - pritisnato
+  uint8_t active; // ima neobraboten rab ili e pritisnato
+  uint8_t long_sent;
+  uint8_t settled; // nivoto e prifateno, sledniot rab zapocnuva nov premin
+  uint32_t first_at; // prviot rab od preminot
+  uint32_t edge_at; // posledniot rab
+  uint32_t down_at;
+  uint8_t ev_press;
+  uint8_t ev_long;
+  uint32_t latency_max; // od prviot rab do kratkiot nastan, vo ms
+} button_t;
+
+/*
+ * Fixed-capacity circular window of samples. Pushing overwrites the
+ * oldest value once the window is full, no shifting is done.
+ */
+typedef struct {
+  int32_t values[WINDOW_DEPTH];
+  uint8_t head; // pozicija za sledniot zapis
+  uint8_t count;
+} sample_window_t;
+
+// edna kolona od pregledot na snimanjeto
+typedef struct {
+  int32_t min;
+  int32_t max;
+  int32_t sum;
+  uint16_t n;
+} env_t;
+
+// merenjata zemeni vo momentot na rokot, cekaat na zapis vo EEPROM
+typedef struct {
+  int32_t v[CH_COUNT];
+} rec_sample_t;
+
+volatile uint32_t msTicks = 0;
+volatile uint8_t cpu_idle = 0;
+idle_stats_t idle_stats;
+uint32_t duty_active = 0; // active_ticks na pocetokot na periodot
+uint32_t duty_sleep = 0;
 uint8_t buf[10];
 uint8_t ch7seg = '1';
 
-char vkupno[5];
-
-int32_t temperatures[13];
-int32_t zapisani[90];
-int32_t measures[13];
-int32_t lights[13];
-int32_t potentiometers[13];
-uint8_t btn1 = 0; // SW3
-uint8_t btn2 = 0; // SW4
-int mode = 1; // 1 - real-time, 2 - save, 3 - show saved
-int measurement_option = 1; // 1 - temperature, 2 - light, 3 - potentiometer
-//uint8_t * song = (uint8_t*)"G1,G1,G1,G1,G1,G1,G1.G1.G1.G1.G1.G1.G1.G1.G1.G1";
+// period na snimanje za cifrite '1'..'9' na 7seg displejot, vo ms; ne pod SAMPLE_PERIOD
+const uint32_t rec_periods[9] = {
+  SAMPLE_PERIOD, 250, 500, 1000, 5000, 10000, 30000, 60000, 300000
+};
+rec_clock_t rec_clock;
+rec_sample_t rec_q[REC_QUEUE_SIZE];
+volatile uint8_t rec_q_head = 0;
+volatile uint8_t rec_q_tail = 0;
+
+int32_t led_shadow = -1; // -1 = nepoznato, prvoto prakjanje sekogas odi
+uint8_t seg_shadow = 0;
+out_stats_t out_stats;
+
+volatile uint32_t adc_ring[ADC_RING_SIZE]; // ADGDR zborovi od DMA
+volatile uint32_t adc_blocks = 0; // popolneti polovini od prstenot
+GPDMA_LLI_Type adc_lli[2];
+
+sample_window_t measures;
+env_t env_cols[ENV_BUCKETS];
+uint16_t env_stride; // zapisi po kofa vo env_cols[]
+uint32_t env_count;
+sample_window_t history[CH_COUNT]; // normalizirani vrednosti za grafikot
+int32_t raw_latest[CH_COUNT];
+store_t store;
+
+i2c_job_t i2c_jobs[I2C_QUEUE_SIZE];
+volatile uint8_t i2c_head = 0;
+volatile uint8_t i2c_tail = 0;
+volatile uint8_t i2c_busy = 0;
+volatile uint8_t i2c_eeprom_wait = 0; // zadacata na redot ceka kraj na ciklusot za zapis
+I2C_M_SETUP_Type i2c_setup;
+i2c_stats_t i2c_stats;
+volatile uint32_t eeprom_ready_at = 0;
+uint8_t light_lsb = 0;
+volatile int8_t acc_z = 0;
+
+acc_sample_t cap_buf[CAP_BUF_SIZE];
+volatile uint32_t cap_head = 0; // vkupno primeroci od startot
+uint32_t cap_tail = 0;
+volatile uint8_t cap_pending = 0;
+uint8_t cap_store = 0; // blokovite odat i vo EEPROM
+uint32_t cap_rate_at = 0;
+uint32_t cap_rate_n = 0;
+cap_stats_t cap_stats;
+
+uint8_t tlm_ring[TLM_RING_SIZE];
+volatile uint16_t tlm_head = 0;
+volatile uint16_t tlm_tail = 0;
+volatile uint8_t tlm_tx_active = 0;
+tlm_stats_t tlm_stats;
+
+log_entry_t log_ring[LOG_RING_SIZE];
+volatile uint32_t log_head = 0;
+uint32_t log_tail = 0;
+log_stats_t log_stats;
+volatile uint32_t light_lux = 0;
+volatile int32_t temp_value = 0; // 0.1 C, poslednoto zavrseno merenje
+volatile uint8_t temp_busy = 0;
+volatile uint8_t temp_edges = 0; // podignati rabovi vo tekovnoto merenje
+volatile uint32_t temp_t0; // TIMER3 na prviot rab
+volatile uint32_t temp_count = 0; // zavrseni merenja
+
+uint8_t fb[OLED_PAGES][OLED_DISPLAY_WIDTH];
+uint8_t shown[OLED_PAGES][OLED_DISPLAY_WIDTH];
+uint8_t fb_dirty_lo[OLED_PAGES];
+uint8_t fb_dirty_hi[OLED_PAGES];
+fb_stats_t fb_stats;
+
+oled_seg_t oled_segs[OLED_SEGMENTS];
+uint8_t oled_cmds[OLED_PAGES][3];
+uint8_t oled_seg_n = 0;
+volatile uint8_t oled_seg_pos = 0;
+volatile uint8_t oled_busy = 0;
+uint32_t oled_xfer_start = 0;
+uint8_t oled_rx_sink[OLED_DISPLAY_WIDTH]; // SSP1 prima dodeka prakja, bajtite ne se koristat
+
+sw_timer_t timers[SCHED_TIMERS];
+volatile uint8_t events[EVENT_QUEUE_SIZE];
+volatile uint8_t ev_head = 0;
+volatile uint8_t ev_tail = 0;
+uint32_t ev_dropped = 0;
+
+int ui_state = UI_MODES;
+sample_window_t * active_window = NULL;
+#define X_NAME(ch, name, rd, norm, bits, bias, led) name,
+char * channel_names[CH_COUNT] = {
+  SENSORS(X_NAME)
+};
+int saved_count = 0;
+uint8_t saved_committed = 0; // procitaj() go najde STORE_COMMIT
+uint8_t saved_resumed = 0; // sesijata prodolzila po reset
+uint8_t saved_back = 0; // kolku sesii pred poslednata e na pregledot
+int rec_n = 0;
+
+volatile uint8_t tone_high = 0;
+uint8_t * song_pos = NULL; // NULL koga ne sviri nisto
+uint32_t song_pause = 0;
+
+button_t sw3 = { 1, 1, 0, 0, 1, 0, 0, 0, EV_SW3, EV_SW3_LONG, 0 }; // P0.4
+button_t sw4 = { 1, 1, 0, 0, 1, 0, 0, 0, EV_SW4, EV_SW4_LONG, 0 }; // P1.31
+char * mode_names[MODE_COUNT] = {
+  "Real time",
+  "Save",
+  "Show saved",
+  "Vibration"
+};
+int mode = MODE_REALTIME;
+int sel_ch = CH_TEMPERATURE; // izbraniot kanal
+//uint8_t * song = (uint8_t*)"G1,G1,G1,G1,G1,G1,G1.G1.G1.G1.G1.G1.G1.G1.G1.G1";
+
+void draw_graph_real_time(sample_window_t * w, char * measurements);
+void zapisi(const int32_t * v);
+static void record_finish(void);
+static void i2c_start_next(void);
+void led_task(void);
+
+static void timer_start(int id, task_fn fn, uint32_t delay, uint32_t period) {
+  timers[id].fn = fn;
+  timers[id].due = msTicks + delay;
+  timers[id].period = period;
+  timers[id].active = 1;
+}
+
+static void timer_stop(int id) {
+  timers[id].active = 0;
+}
+
+// moze da se povika i od prekin
+static void event_post(uint8_t ev) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if ((uint8_t)(ev_head - ev_tail) < EVENT_QUEUE_SIZE) {
+    events[ev_head & (EVENT_QUEUE_SIZE - 1)] = ev;
+    ev_head++;
+  } else {
+    ev_dropped++;
+  }
+  __set_PRIMASK(primask);
+}
+
+static uint8_t event_get(void) {
+  uint8_t ev = EV_NONE;
+  __disable_irq();
+  if (ev_tail != ev_head) {
+    ev = events[ev_tail & (EVENT_QUEUE_SIZE - 1)];
+    ev_tail++;
+  }
+  __enable_irq();
+  return ev;
+}
+
+static void button_edge(button_t * b) {
+  if (b->settled)
+    b->first_at = msTicks;
+  b->settled = 0;
+  b->edge_at = msTicks;
+  b->active = 1;
+}
+
+static void button_press(button_t * b, uint32_t now) {
+  if (now - b->first_at > b->latency_max)
+    b->latency_max = now - b->first_at;
+  event_post(b->ev_press);
+}
+
+// se povikuva od SysTick sekoja ms so momentalnoto nivo na pinot
+static void button_tick(button_t * b, uint8_t level) {
+  uint32_t now = msTicks;
+
+  if (level != b->raw) {
+    b->raw = level;
+    button_edge(b);
+  }
+  if (!b->active)
+    return;
+
+  if (b->raw != b->stable && now - b->edge_at >= DEBOUNCE_MS) {
+    b->stable = b->raw;
+    b->settled = 1;
+    if (b->stable == 0) {
+      b->down_at = now;
+      b->long_sent = 0;
+      if (b->ev_long == EV_NONE)
+        button_press(b, now);
+    } else if (b->ev_long != EV_NONE && !b->long_sent) {
+      button_press(b, now);
+    }
+  }
+
+  if (b->stable == 0) {
+    if (!b->long_sent && now - b->down_at >= LONG_PRESS_MS) {
+      b->long_sent = 1;
+      if (b->ev_long != EV_NONE)
+        event_post(b->ev_long);
+    }
+  } else if (b->raw == b->stable) {
+    b->active = 0;
+    b->settled = 1; // i koga bilo samo odbivanje
+  }
+}
+
+/*
+ * Port 0 GPIO interrupts: SW3 on both edges, P0.2 on rising edges
+ * while a temperature measurement runs. GPIO_IntCmd() writes the whole
+ * enable register instead of setting bits, so both masks are always
+ * written together from here.
+ */
+static void gpio0_int_update(void) {
+  GPIO_IntCmd(0, (1 << 4) | (temp_busy ? 1 << TEMP_PIN : 0), 0);
+  GPIO_IntCmd(0, 1 << 4, 1);
+}
+
+/*
+ * SW3 is on P0.4 and raises GPIO interrupts on both edges. P1.31 (SW4)
+ * is on a port without GPIO interrupts, so it is sampled every tick.
+ */
+static void init_buttons(void) {
+  GPIO_SetDir(0, 1 << 4, 0);
+  GPIO_SetDir(1, 1 << 31, 0);
+
+  gpio0_int_update();
+  NVIC_EnableIRQ(EINT3_IRQn);
+}
+
+/*
+ * MAX6576 without blocking. The sensor's output period is 10 us per
+ * kelvin; TIMER3 runs freely in microseconds and every rising edge on
+ * P0.2 is timestamped from EINT3. After TEMP_PERIODS periods the mean
+ * period gives the temperature in 0.1 C and the edge interrupt is
+ * switched off again.
+ */
+static void init_temp(void) {
+  TIM_TIMERCFG_Type TIM_ConfigStruct;
+
+  GPIO_SetDir(0, 1 << TEMP_PIN, 0);
+
+  TIM_ConfigStruct.PrescaleOption = TIM_PRESCALE_USVAL;
+  TIM_ConfigStruct.PrescaleValue = 1;
+  TIM_Init(LPC_TIM3, TIM_TIMER_MODE, & TIM_ConfigStruct);
+  TIM_Cmd(LPC_TIM3, ENABLE);
+}
+
+// TIMER3 broi mikrosekundi, za merenjata pod edna milisekunda
+static uint32_t us_now(void) {
+  return LPC_TIM3->TC;
+}
+
+// novata vrednost stignuva vo temp_value
+static void temp_request(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (!temp_busy) {
+    temp_busy = 1;
+    temp_edges = 0;
+    gpio0_int_update();
+  }
+  __set_PRIMASK(primask);
+}
+
+static void temp_edge(void) {
+  uint32_t now = LPC_TIM3->TC;
+
+  if (temp_edges++ == 0) {
+    temp_t0 = now;
+    return;
+  }
+  if (temp_edges <= TEMP_PERIODS)
+    return;
+
+  temp_value = (int32_t)((now - temp_t0 + TEMP_PERIODS / 2) / TEMP_PERIODS) - TEMP_ZERO_US;
+  temp_count++;
+  temp_busy = 0;
+  gpio0_int_update();
+}
+
+void EINT3_IRQHandler(void) {
+  if (GPIO_GetIntStatus(0, 4, 0) || GPIO_GetIntStatus(0, 4, 1)) {
+    GPIO_ClearInt(0, 1 << 4);
+    button_edge( & sw3);
+  }
+  if (GPIO_GetIntStatus(0, TEMP_PIN, 0)) {
+    GPIO_ClearInt(0, 1 << TEMP_PIN);
+    if (temp_busy)
+      temp_edge();
+  }
+}
+
+void SysTick_Handler(void) {
+  msTicks++;
+  if (cpu_idle)
+    idle_stats.sleep_ticks++;
+  else
+    idle_stats.active_ticks++;
+
+  if (sw3.active)
+    button_tick( & sw3, (GPIO_ReadValue(0) >> 4) & 0x01);
+  button_tick( & sw4, (GPIO_ReadValue(1) >> 31) & 0x01);
+
+  if (i2c_eeprom_wait && (int32_t)(msTicks - eeprom_ready_at) >= 0) {
+    i2c_eeprom_wait = 0;
+    i2c_start_next();
+  }
+}
+
+/*
+ * Sleeps until the next interrupt, at the latest the next SysTick.
+ * Called with PRIMASK set, after the wait condition was checked: an
+ * interrupt that comes after the check still wakes WFI, and its handler
+ * runs at __enable_irq() while cpu_idle is set, so the SysTick that
+ * ends the sleep is counted as sleep. In the host build __WFI() comes
+ * from the simulator and advances the virtual clock to the next
+ * interrupt, so the same accounting applies.
+ */
+static void cpu_sleep(void) {
+  cpu_idle = 1;
+  idle_stats.wakeups++;
+#if IDLE_WFI
+  __WFI();
+#endif
+  __enable_irq();
+  cpu_idle = 0;
+}
+
+// ceka dodeka vazi cond, proverkata i WFI se pod PRIMASK
+#define CPU_WAIT_WHILE(cond) \
+  do { \
+    __disable_irq(); \
+    while (cond) { \
+      cpu_sleep(); \
+      __disable_irq(); \
+    } \
+    __enable_irq(); \
+  } while (0)
+
+static void init_ssp(void) {
+  SSP_CFG_Type SSP_ConfigStruct;
+  PINSEL_CFG_Type PinCfg;
+
+  /*
+   * Initialize SPI pin connect
+   * P0.7 - SCK;
+   * P0.8 - MISO
+   * P0.9 - MOSI
+   * P2.2 - SSEL - used as GPIO
+   */
+  PinCfg.Funcnum = 2;
+  PinCfg.OpenDrain = 0;
+  PinCfg.Pinmode = 0;
+  PinCfg.Portnum = 0;
+  PinCfg.Pinnum = 7;
+  PINSEL_ConfigPin( & PinCfg);
+  PinCfg.Pinnum = 8;
+  PINSEL_ConfigPin( & PinCfg);
+  PinCfg.Pinnum = 9;
+  PINSEL_ConfigPin( & PinCfg);
+  PinCfg.Funcnum = 0;
+  PinCfg.Portnum = 2;
+  PinCfg.Pinnum = 2;
+  PINSEL_ConfigPin( & PinCfg);
+
+  SSP_ConfigStructInit( & SSP_ConfigStruct);
+
+  // Initialize SSP peripheral with parameter given in structure above
+  SSP_Init(LPC_SSP1, & SSP_ConfigStruct);
+
+  // Enable SSP peripheral
+  SSP_Cmd(LPC_SSP1, ENABLE);
+
+#if OLED_USE_DMA
+  SSP_DMACmd(LPC_SSP1, SSP_DMA_TX, ENABLE);
+  SSP_DMACmd(LPC_SSP1, SSP_DMA_RX, ENABLE);
+#endif
+
+}
+
+// GPDMA go delat ADC prstenot i OLED, DMA_IRQHandler gi opsluzuva dvata
+static void init_dma(void) {
+  GPDMA_Init();
+  NVIC_EnableIRQ(DMA_IRQn);
+}
+
+static void init_i2c(void) {
+  PINSEL_CFG_Type PinCfg;
+
+  /* Initialize I2C2 pin connect */
+  PinCfg.Funcnum = 2;
+  PinCfg.Pinnum = 10;
+  PinCfg.Portnum = 0;
+  PINSEL_ConfigPin( & PinCfg);
+  PinCfg.Pinnum = 11;
+  PINSEL_ConfigPin( & PinCfg);
+
+  // Initialize I2C peripheral
+  I2C_Init(LPC_I2C2, 100000);
+
+  /* Enable I2C1 operation */
+  I2C_Cmd(LPC_I2C2, ENABLE);
+}
+
+/*
+ * Asynchronous I2C2 queue. Jobs are started one after another from
+ * I2C2_IRQHandler, completion callbacks run in interrupt context and
+ * must stay short. The blocking EA drivers may only be used after
+ * i2c_sync().
+ *
+ * The EEPROM NACKs its address for EEPROM_WRITE_MS after a write. An
+ * EEPROM job that reaches the head of the queue before eeprom_ready_at
+ * is not started; SysTick starts it once the write cycle is over, and
+ * the jobs behind it wait with it so the order is kept.
+ */
+static void i2c_job_done(void) {
+  i2c_job_t * j = & i2c_jobs[i2c_tail & (I2C_QUEUE_SIZE - 1)];
+  int ok = (i2c_setup.status & I2C_SETUP_STATUS_DONE) != 0;
+
+  if (!ok)
+    i2c_stats.failed++;
+  i2c_stats.bytes += 1 + j->tx_len + j->rx_len;
+  // +1 za zapocnatata milisekunda
+  if (j->addr == EEPROM_I2C_ADDR && j->rx_len == 0)
+    eeprom_ready_at = msTicks + EEPROM_WRITE_MS + 1;
+  if (j->done != NULL)
+    j->done(j->rx, ok);
+
+  i2c_tail++;
+  i2c_busy = 0;
+  if (i2c_tail != i2c_head)
+    i2c_start_next();
+}
+
+static void i2c_start_next(void) {
+  i2c_job_t * j = & i2c_jobs[i2c_tail & (I2C_QUEUE_SIZE - 1)];
+
+  i2c_busy = 1;
+  if (j->addr == EEPROM_I2C_ADDR && (int32_t)(msTicks - eeprom_ready_at) < 0) {
+    i2c_eeprom_wait = 1;
+    return;
+  }
+  i2c_setup.sl_addr7bit = j->addr;
+  i2c_setup.tx_data = j->tx_len ? j->tx : NULL;
+  i2c_setup.tx_length = j->tx_len;
+  i2c_setup.rx_data = j->rx_len ? j->rx : NULL;
+  i2c_setup.rx_length = j->rx_len;
+  i2c_setup.retransmissions_max = 3;
+  i2c_setup.callback = i2c_job_done;
+  I2C_MasterTransferData(LPC_I2C2, & i2c_setup, I2C_TRANSFER_INTERRUPT);
+}
+
+// vrakja 0 ako redicata e polna, moze i od prekin (TIMER1)
+static int i2c_submit(uint8_t addr, const uint8_t * tx, uint8_t tx_len, uint8_t rx_len, i2c_done_fn done) {
+  int ok = 0;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  uint8_t depth = i2c_head - i2c_tail;
+  if (depth < I2C_QUEUE_SIZE) {
+    i2c_job_t * j = & i2c_jobs[i2c_head & (I2C_QUEUE_SIZE - 1)];
+    j->addr = addr;
+    j->tx_len = tx_len;
+    j->rx_len = rx_len;
+    memcpy(j->tx, tx, tx_len);
+    j->done = done;
+    i2c_head++;
+
+    if (depth + 1 > i2c_stats.depth_max)
+      i2c_stats.depth_max = depth + 1;
+    i2c_stats.jobs++;
+    if (!i2c_busy)
+      i2c_start_next();
+    ok = 1;
+  } else {
+    i2c_stats.dropped++;
+  }
+  __set_PRIMASK(primask);
+  return ok;
+}
+
+void I2C2_IRQHandler(void) {
+  I2C_MasterHandler(LPC_I2C2);
+}
+
+// ceka da se isprazni redicata i EEPROM da zavrsi so zapisuvanje
+static void i2c_sync(void) {
+  CPU_WAIT_WHILE(i2c_busy || i2c_head != i2c_tail);
+  CPU_WAIT_WHILE((int32_t)(msTicks - eeprom_ready_at) < 0);
+}
+
+/*
+ * One page write. It queues behind the previous one, which is held
+ * back until its write cycle is over; only a full queue makes the
+ * caller wait.
+ */
+static void eeprom_write_async(const uint8_t * b, uint16_t offset, uint8_t len) {
+  uint8_t tx[I2C_MAX_TX];
+
+  tx[0] = offset >> 8;
+  tx[1] = offset & 0xff;
+  memcpy( & tx[2], b, len);
+  CPU_WAIT_WHILE((uint8_t)(i2c_head - i2c_tail) >= I2C_QUEUE_SIZE);
+  i2c_submit(EEPROM_I2C_ADDR, tx, len + 2, 0, NULL);
+}
+
+// ista sostojba na LED kako pca9532_setLeds(on, 0xffff)
+static void pca9532_setLedsAsync(uint16_t on) {
+  uint8_t tx[5];
+
+  tx[0] = PCA9532_LS0_AUTO_INC;
+  for (int i = 0; i < 4; i++) {
+    uint8_t ls = 0;
+    for (int k = 0; k < 4; k++)
+      if (on & (1 << (i * 4 + k)))
+        ls |= 1 << (k * 2);
+    tx[i + 1] = ls;
+  }
+  i2c_submit(PCA9532_I2C_ADDR, tx, sizeof(tx), 0, NULL);
+}
+
+static void light_lsb_done(uint8_t * rx, int ok) {
+  if (ok)
+    light_lsb = rx[0];
+}
+
+static void light_msb_done(uint8_t * rx, int ok) {
+  if (ok)
+    light_lux = (LIGHT_RANGE * (uint32_t)((rx[0] << 8) | light_lsb)) >> 16;
+}
+
+// novata vrednost stignuva vo light_lux
+static void light_request(void) {
+  uint8_t reg = LIGHT_REG_LSB;
+  i2c_submit(LIGHT_I2C_ADDR, & reg, 1, 1, light_lsb_done);
+  reg = LIGHT_REG_MSB;
+  i2c_submit(LIGHT_I2C_ADDR, & reg, 1, 1, light_msb_done);
+}
+
+static void acc_z_done(uint8_t * rx, int ok) {
+  if (ok)
+    acc_z = (int8_t) rx[0];
+}
+
+// novata vrednost stignuva vo acc_z
+static void acc_request(void) {
+  uint8_t reg = ACC_REG_ZOUT8;
+  i2c_submit(ACC_I2C_ADDR, & reg, 1, 1, acc_z_done);
+}
+
+static void acc_write(uint8_t reg, uint8_t val) {
+  uint8_t tx[2] = { reg, val };
+  i2c_submit(ACC_I2C_ADDR, tx, sizeof(tx), 0, NULL);
+}
+
+/*
+ * Capture samples arrive in cap_buf from the I2C interrupt and are
+ * drained by cap_task(). The sensor auto-increments the register
+ * address, so one transaction returns X, Y, Z and STATUS.
+ */
+static void cap_done(uint8_t * rx, int ok) {
+  cap_pending = 0;
+  if (!ok) {
+    cap_stats.failed++;
+    return;
+  }
+
+  acc_sample_t * s = & cap_buf[cap_head & (CAP_BUF_SIZE - 1)];
+  s->x = (int8_t) rx[0];
+  s->y = (int8_t) rx[1];
+  s->z = (int8_t) rx[2];
+  if (rx[3] & ACC_STATUS_DOVR)
+    cap_stats.overruns++;
+  cap_stats.samples++;
+  cap_head++;
+}
+
+// od TIMER1, ako prethodnoto citanje ne zavrsilo primerokot propagja
+static void cap_tick(void) {
+  uint8_t reg = ACC_REG_XOUT8;
+
+  if (cap_pending) {
+    cap_stats.skipped++;
+    return;
+  }
+  cap_pending = 1;
+  if (!i2c_submit(ACC_I2C_ADDR, & reg, 1, CAP_BURST, cap_done)) {
+    cap_pending = 0;
+    cap_stats.skipped++;
+  }
+}
+
+/*
+ * Binary telemetry on UART3 (P0.0 TXD3, P0.1 RXD3), 115200 8N1.
+ * Packets are queued into a ring buffer and sent from the THRE
+ * interrupt, so no sampling loop waits for the serial line.
+ *
+ *   0xa5 seq ch t0 t1 t2 t3 v0 v1 v2 v3 sum
+ *
+ * seq counts packets (a gap means loss), t is msTicks and v is the
+ * signed value, both little endian. sum makes the 8-bit sum of bytes
+ * 1..11 zero. A packet that does not fit is dropped whole.
+ */
+#if TELEMETRY
+static void tlm_fill_fifo(void) {
+  for (int i = 0; i < UART_TX_FIFO_SIZE && tlm_tail != tlm_head; i++) {
+    UART_SendByte(LPC_UART3, tlm_ring[tlm_tail & (TLM_RING_SIZE - 1)]);
+    tlm_tail++;
+  }
+  tlm_tx_active = 1;
+}
+
+void UART3_IRQHandler(void) {
+  if ((UART_GetIntId(LPC_UART3) & UART_IIR_INTID_MASK) != UART_IIR_INTID_THRE)
+    return;
+  if (tlm_tail == tlm_head)
+    tlm_tx_active = 0;
+  else
+    tlm_fill_fifo();
+}
+
+static void init_tlm(void) {
+  PINSEL_CFG_Type PinCfg;
+  UART_CFG_Type UARTConfigStruct;
+  UART_FIFO_CFG_Type UARTFIFOConfigStruct;
+
+  PinCfg.Funcnum = 2;
+  PinCfg.OpenDrain = 0;
+  PinCfg.Pinmode = 0;
+  PinCfg.Portnum = 0;
+  PinCfg.Pinnum = 0;
+  PINSEL_ConfigPin( & PinCfg);
+  PinCfg.Pinnum = 1;
+  PINSEL_ConfigPin( & PinCfg);
+
+  UART_ConfigStructInit( & UARTConfigStruct);
+  UARTConfigStruct.Baud_rate = TLM_BAUD;
+  UART_Init(LPC_UART3, & UARTConfigStruct);
+
+  UART_FIFOConfigStructInit( & UARTFIFOConfigStruct);
+  UART_FIFOConfig(LPC_UART3, & UARTFIFOConfigStruct);
+
+  UART_TxCmd(LPC_UART3, ENABLE);
+  UART_IntConfig(LPC_UART3, UART_INTCFG_THRE, ENABLE);
+  NVIC_EnableIRQ(UART3_IRQn);
+}
+
+// zapisuva cel paket vo baferot ili nisto, vrakja 0 ako nema mesto
+static int tlm_queue(const uint8_t * b, uint8_t len) {
+  int ok = 0;
+
+  NVIC_DisableIRQ(UART3_IRQn);
+  if ((uint16_t)(tlm_head - tlm_tail) <= TLM_RING_SIZE - len) {
+    for (int i = 0; i < len; i++)
+      tlm_ring[tlm_head++ & (TLM_RING_SIZE - 1)] = b[i];
+    if (!tlm_tx_active)
+      tlm_fill_fifo();
+    ok = 1;
+  }
+  NVIC_EnableIRQ(UART3_IRQn);
+  return ok;
+}
+
+static void tlm_send(uint8_t ch, int32_t value) {
+  uint8_t pkt[TLM_PACKET_SIZE];
+  uint32_t t = msTicks;
+  uint8_t sum = 0;
+
+  pkt[0] = TLM_SYNC;
+  pkt[1] = tlm_stats.seq++;
+  pkt[2] = ch;
+  for (int i = 0; i < 4; i++) {
+    pkt[3 + i] = t >> (i * 8);
+    pkt[7 + i] = (uint32_t) value >> (i * 8);
+  }
+  for (int i = 1; i < TLM_PACKET_SIZE - 1; i++)
+    sum += pkt[i];
+  pkt[TLM_PACKET_SIZE - 1] = -sum;
+
+  if (tlm_queue(pkt, TLM_PACKET_SIZE))
+    tlm_stats.packets++;
+  else
+    tlm_stats.dropped++;
+}
+#else
+static int tlm_queue(const uint8_t * b, uint8_t len) {
+  return 1;
+}
+
+static void tlm_send(uint8_t ch, int32_t value) {}
+#endif
+
+/*
+ * Deferred-formatting log. LOG() stores an ID and up to LOG_MAX_ARGS
+ * integers, from main or interrupt context. A slot is claimed with a
+ * compare-and-swap on log_head and published by writing its seq last.
+ * log_flush() runs from the main loop and sends the finished entries
+ * on the telemetry UART:
+ *
+ *   0x5a id n t0 t1 t2 t3 args (4 bytes each, little endian) sum
+ */
+#define LOG(id, ...) do { \
+    int32_t log_a_[] = { __VA_ARGS__ }; \
+    log_put(id, sizeof(log_a_) / sizeof(log_a_[0]), log_a_); \
+  } while (0)
+
+static int log_claim(uint32_t * slot) {
+  uint32_t h;
+
+#ifdef __arm__
+  do {
+    h = __LDREXW((uint32_t * ) & log_head);
+    if (h - log_tail >= LOG_RING_SIZE) {
+      __CLREX();
+      return 0;
+    }
+  } while (__STREXW(h + 1, (uint32_t * ) & log_head));
+#else
+  do {
+    h = log_head;
+    if (h - log_tail >= LOG_RING_SIZE)
+      return 0;
+  } while (!__sync_bool_compare_and_swap( & log_head, h, h + 1));
+#endif
+  * slot = h;
+  return 1;
+}
+
+static void log_put(uint8_t id, uint8_t n, const int32_t * args) {
+  uint32_t h;
+
+  if (!log_claim( & h)) {
+    log_stats.dropped++;
+    return;
+  }
+
+  log_entry_t * e = & log_ring[h & (LOG_RING_SIZE - 1)];
+  e->at = msTicks;
+  e->id = id;
+  e->n = n;
+  memcpy(e->args, args, n * sizeof(int32_t));
+  e->seq = h + 1;
+}
+
+static void log_flush(void) {
+  uint8_t b[8 + LOG_MAX_ARGS * 4];
+
+  while (log_tail != log_head) {
+    log_entry_t * e = & log_ring[log_tail & (LOG_RING_SIZE - 1)];
+    if (e->seq != log_tail + 1)
+      break; // se uste se zapisuva
+
+    uint8_t len = 0;
+    uint8_t sum = 0;
+    b[len++] = LOG_SYNC;
+    b[len++] = e->id;
+    b[len++] = e->n;
+    for (int i = 0; i < 4; i++)
+      b[len++] = e->at >> (i * 8);
+    for (int a = 0; a < e->n; a++)
+      for (int i = 0; i < 4; i++)
+        b[len++] = (uint32_t) e->args[a] >> (i * 8);
+    for (int i = 1; i < len; i++)
+      sum += b[i];
+    b[len++] = -sum;
+
+    if (!tlm_queue(b, len))
+      break; // probaj pak vo sledniot ciklus
+    log_stats.written++;
+    log_tail++;
+  }
+}
+
+/*
+ * Hot-path profiling. The scopes count core cycles with the DWT cycle
+ * counter; the host build's LPC17xx.h provides one that runs off the
+ * monotonic clock at SystemCoreClock, so prof_dump() logs the same
+ * report in both places. With PROFILE 0 the markers compile to nothing.
+ */
+#if PROFILE
+#ifndef DWT_CYCCNT // CMSIS 1.30 nema DWT
+#define DWT_CTRL ( * (volatile uint32_t * ) 0xe0001000)
+#define DWT_CYCCNT ( * (volatile uint32_t * ) 0xe0001004)
+#define DEMCR ( * (volatile uint32_t * ) 0xe000edfc)
+#endif
+#define PROF_NOW() DWT_CYCCNT
+#define PROF_UNIT 0 // cycles
+
+#define PROF_BEGIN(id) uint32_t prof_t_##id = PROF_NOW()
+#define PROF_END(id) prof_record(id, PROF_NOW() - prof_t_##id)
+
+prof_stat_t prof_stats[PRF_COUNT];
+prof_trace_t prof_trace[PROF_TRACE_SIZE];
+uint32_t prof_trace_head = 0;
+
+static void init_prof(void) {
+  DEMCR |= 1 << 24; // TRCENA
+  DWT_CYCCNT = 0;
+  DWT_CTRL |= 1; // CYCCNTENA
+  for (int i = 0; i < PRF_COUNT; i++)
+    prof_stats[i].min = 0xffffffff;
+}
+
+static void prof_record(uint8_t id, uint32_t ticks) {
+  prof_stat_t * st = & prof_stats[id];
+  prof_trace_t * tr = & prof_trace[prof_trace_head++ & (PROF_TRACE_SIZE - 1)];
+
+  st->count++;
+  st->sum += ticks;
+  if (ticks < st->min)
+    st->min = ticks;
+  if (ticks > st->max)
+    st->max = ticks;
+
+  tr->scope = id;
+  tr->at = msTicks;
+  tr->ticks = ticks;
+}
+
+// izvestaj: min/avg/max po del, pa poslednite zapisi od tragata
+static void prof_dump(void) {
+  LOG(LOG_PROF_HEADER, PROF_UNIT);
+  for (int i = 0; i < PRF_COUNT; i++) {
+    prof_stat_t * st = & prof_stats[i];
+    if (st->count == 0)
+      continue;
+    LOG(LOG_PROF_STAT, i, st->count, st->min, (uint32_t)(st->sum / st->count), st->max);
+  }
+
+  uint32_t n = prof_trace_head < PROF_DUMP_TRACE ? prof_trace_head : PROF_DUMP_TRACE;
+  for (uint32_t i = prof_trace_head - n; i != prof_trace_head; i++) {
+    prof_trace_t * tr = & prof_trace[i & (PROF_TRACE_SIZE - 1)];
+    LOG(LOG_PROF_TRACE, tr->at, tr->scope, tr->ticks);
+  }
+}
+#else
+#define PROF_BEGIN(id)
+#define PROF_END(id)
+#define init_prof()
+#define prof_dump()
+#endif
+
+/*
+ * GPDMA copies ADGDR into adc_ring[] after every conversion. The two
+ * linked list items chain the halves of the ring into a circle, so the
+ * channel never stops, and the terminal count interrupt at the end of
+ * each half is the only one the ADC costs, ADC_RING_SIZE / 2 samples
+ * apart. The ADC interrupt itself stays off in the NVIC; its enable bit
+ * is only there to raise the DMA request.
+ */
+static void adc_dma_start(void) {
+  GPDMA_Channel_CFG_Type cfg;
+  uint32_t ctl = GPDMA_DMACCxControl_TransferSize(ADC_RING_SIZE / 2)
+    | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD)
+    | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD)
+    | GPDMA_DMACCxControl_DI | GPDMA_DMACCxControl_I;
+
+  for (int i = 0; i < 2; i++) {
+    adc_lli[i].SrcAddr = (uintptr_t) & LPC_ADC->ADGDR;
+    adc_lli[i].DstAddr = (uintptr_t) & adc_ring[i * ADC_RING_SIZE / 2];
+    adc_lli[i].NextLLI = (uintptr_t) & adc_lli[1 - i];
+    adc_lli[i].Control = ctl;
+  }
+
+  cfg.ChannelNum = ADC_DMA_CH;
+  cfg.TransferSize = ADC_RING_SIZE / 2;
+  cfg.TransferWidth = 0;
+  cfg.SrcMemAddr = 0;
+  cfg.DstMemAddr = adc_lli[0].DstAddr;
+  cfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+  cfg.SrcConn = GPDMA_CONN_ADC;
+  cfg.DstConn = 0;
+  cfg.DMALLI = (uintptr_t) & adc_lli[1];
+  GPDMA_Setup( & cfg);
+  GPDMA_ChannelCmd(ADC_DMA_CH, ENABLE);
+}
+
+static void init_adc(void) {
+  PINSEL_CFG_Type PinCfg;
+
+  /*
+   * Init ADC pin connect
+   * AD0.0 on P0.23
+   */
+  PinCfg.Funcnum = 1;
+  PinCfg.OpenDrain = 0;
+  PinCfg.Pinmode = 0;
+  PinCfg.Pinnum = 23;
+  PinCfg.Portnum = 0;
+  PINSEL_ConfigPin( & PinCfg);
+
+  /* Configuration for ADC :
+   *  Burst mode at ADC_SAMPLE_RATE conversions per second
+   *  ADC channel 0, DMA request on every conversion
+   */
+  ADC_Init(LPC_ADC, ADC_SAMPLE_RATE);
+  ADC_ChannelCmd(LPC_ADC, ADC_CHANNEL_0, ENABLE);
+  // ADGINTEN e vklucen po reset, DONE vo ADGDR bi go drzel prekinot
+  ADC_IntConfig(LPC_ADC, ADC_ADGINTEN, DISABLE);
+  ADC_IntConfig(LPC_ADC, ADC_ADINTEN0, ENABLE);
+
+  adc_dma_start();
+  ADC_BurstCmd(LPC_ADC, ENABLE);
+}
+
+// od DMA_IRQHandler, edna polovina od prstenot e polna
+static void adc_dma_irq(void) {
+  if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, ADC_DMA_CH) == SET)
+    GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, ADC_DMA_CH);
+  if (GPDMA_IntGetStatus(GPDMA_STAT_INTTC, ADC_DMA_CH) == SET) {
+    GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, ADC_DMA_CH);
+    adc_blocks++;
+  }
+}
+
+/*
+ * Mean of the last n conversions, without waiting for one. The slot
+ * DMA writes next is taken from the channel's destination address;
+ * slots it has not filled yet have no DONE flag and are skipped.
+ */
+static uint16_t adc_average(int n) {
+  uint32_t pos = (ADC_DMA_REGS->DMACCDestAddr - (uintptr_t) adc_ring) / sizeof(adc_ring[0]);
+  uint32_t sum = 0;
+  int got = 0;
+
+  for (int i = 1; i <= n; i++) {
+    uint32_t w = adc_ring[(pos - i) & (ADC_RING_SIZE - 1)];
+    if (w & ADC_GDR_DONE_FLAG) {
+      sum += ADC_GDR_RESULT(w);
+      got++;
+    }
+  }
+  return got ? sum / got : 0;
+}
+
+/*
+ * RAM framebuffer for the OLED. All drawing goes to fb[], fb_flush()
+ * then compares it with shown[] (what the panel already displays) and
+ * sends only the changed column span of every dirty page over SSP1.
+ * One byte covers 8 vertical pixels, bit set = OLED_COLOR_WHITE.
+ */
+static const uint8_t font5x7[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, // ' '
+  0x00, 0x00, 0x5f, 0x00, 0x00, // !
+  0x00, 0x07, 0x00, 0x07, 0x00, // "
+  0x14, 0x7f, 0x14, 0x7f, 0x14, // #
+  0x24, 0x2a, 0x7f, 0x2a, 0x12, // $
+  0x23, 0x13, 0x08, 0x64, 0x62, // %
+  0x36, 0x49, 0x55, 0x22, 0x50, // &
+  0x00, 0x05, 0x03, 0x00, 0x00, // '
+  0x00, 0x1c, 0x22, 0x41, 0x00, // (
+  0x00, 0x41, 0x22, 0x1c, 0x00, // )
+  0x08, 0x2a, 0x1c, 0x2a, 0x08, // *
+  0x08, 0x08, 0x3e, 0x08, 0x08, // +
+  0x00, 0x50, 0x30, 0x00, 0x00, // ,
+  0x08, 0x08, 0x08, 0x08, 0x08, // -
+  0x00, 0x60, 0x60, 0x00, 0x00, // .
+  0x20, 0x10, 0x08, 0x04, 0x02, // /
+  0x3e, 0x51, 0x49, 0x45, 0x3e, // 0
+  0x00, 0x42, 0x7f, 0x40, 0x00, // 1
+  0x42, 0x61, 0x51, 0x49, 0x46, // 2
+  0x21, 0x41, 0x45, 0x4b, 0x31, // 3
+  0x18, 0x14, 0x12, 0x7f, 0x10, // 4
+  0x27, 0x45, 0x45, 0x45, 0x39, // 5
+  0x3c, 0x4a, 0x49, 0x49, 0x30, // 6
+  0x01, 0x71, 0x09, 0x05, 0x03, // 7
+  0x36, 0x49, 0x49, 0x49, 0x36, // 8
+  0x06, 0x49, 0x49, 0x29, 0x1e, // 9
+  0x00, 0x36, 0x36, 0x00, 0x00, // :
+  0x00, 0x56, 0x36, 0x00, 0x00, // ;
+  0x00, 0x08, 0x14, 0x22, 0x41, // <
+  0x14, 0x14, 0x14, 0x14, 0x14, // =
+  0x41, 0x22, 0x14, 0x08, 0x00, // >
+  0x02, 0x01, 0x51, 0x09, 0x06, // ?
+  0x32, 0x49, 0x79, 0x41, 0x3e, // @
+  0x7e, 0x11, 0x11, 0x11, 0x7e, // A
+  0x7f, 0x49, 0x49, 0x49, 0x36, // B
+  0x3e, 0x41, 0x41, 0x41, 0x22, // C
+  0x7f, 0x41, 0x41, 0x22, 0x1c, // D
+  0x7f, 0x49, 0x49, 0x49, 0x41, // E
+  0x7f, 0x09, 0x09, 0x01, 0x01, // F
+  0x3e, 0x41, 0x41, 0x51, 0x32, // G
+  0x7f, 0x08, 0x08, 0x08, 0x7f, // H
+  0x00, 0x41, 0x7f, 0x41, 0x00, // I
+  0x20, 0x40, 0x41, 0x3f, 0x01, // J
+  0x7f, 0x08, 0x14, 0x22, 0x41, // K
+  0x7f, 0x40, 0x40, 0x40, 0x40, // L
+  0x7f, 0x02, 0x04, 0x02, 0x7f, // M
+  0x7f, 0x04, 0x08, 0x10, 0x7f, // N
+  0x3e, 0x41, 0x41, 0x41, 0x3e, // O
+  0x7f, 0x09, 0x09, 0x09, 0x06, // P
+  0x3e, 0x41, 0x51, 0x21, 0x5e, // Q
+  0x7f, 0x09, 0x19, 0x29, 0x46, // R
+  0x46, 0x49, 0x49, 0x49, 0x31, // S
+  0x01, 0x01, 0x7f, 0x01, 0x01, // T
+  0x3f, 0x40, 0x40, 0x40, 0x3f, // U
+  0x1f, 0x20, 0x40, 0x20, 0x1f, // V
+  0x7f, 0x20, 0x18, 0x20, 0x7f, // W
+  0x63, 0x14, 0x08, 0x14, 0x63, // X
+  0x03, 0x04, 0x78, 0x04, 0x03, // Y
+  0x61, 0x51, 0x49, 0x45, 0x43, // Z
+  0x00, 0x00, 0x7f, 0x41, 0x41, // [
+  0x02, 0x04, 0x08, 0x10, 0x20, // backslash
+  0x41, 0x41, 0x7f, 0x00, 0x00, // ]
+  0x04, 0x02, 0x01, 0x02, 0x04, // ^
+  0x40, 0x40, 0x40, 0x40, 0x40, // _
+  0x00, 0x01, 0x02, 0x04, 0x00, // `
+  0x20, 0x54, 0x54, 0x54, 0x78, // a
+  0x7f, 0x48, 0x44, 0x44, 0x38, // b
+  0x38, 0x44, 0x44, 0x44, 0x20, // c
+  0x38, 0x44, 0x44, 0x48, 0x7f, // d
+  0x38, 0x54, 0x54, 0x54, 0x18, // e
+  0x08, 0x7e, 0x09, 0x01, 0x02, // f
+  0x08, 0x14, 0x54, 0x54, 0x3c, // g
+  0x7f, 0x08, 0x04, 0x04, 0x78, // h
+  0x00, 0x44, 0x7d, 0x40, 0x00, // i
+  0x20, 0x40, 0x44, 0x3d, 0x00, // j
+  0x00, 0x7f, 0x10, 0x28, 0x44, // k
+  0x00, 0x41, 0x7f, 0x40, 0x00, // l
+  0x7c, 0x04, 0x18, 0x04, 0x78, // m
+  0x7c, 0x08, 0x04, 0x04, 0x78, // n
+  0x38, 0x44, 0x44, 0x44, 0x38, // o
+  0x7c, 0x14, 0x14, 0x14, 0x08, // p
+  0x08, 0x14, 0x14, 0x18, 0x7c, // q
+  0x7c, 0x08, 0x04, 0x04, 0x08, // r
+  0x48, 0x54, 0x54, 0x54, 0x20, // s
+  0x04, 0x3f, 0x44, 0x40, 0x20, // t
+  0x3c, 0x40, 0x40, 0x20, 0x7c, // u
+  0x1c, 0x20, 0x40, 0x20, 0x1c, // v
+  0x3c, 0x40, 0x30, 0x40, 0x3c, // w
+  0x44, 0x28, 0x10, 0x28, 0x44, // x
+  0x0c, 0x50, 0x50, 0x50, 0x3c, // y
+  0x44, 0x64, 0x54, 0x4c, 0x44, // z
+  0x00, 0x08, 0x36, 0x41, 0x00, // {
+  0x00, 0x00, 0x7f, 0x00, 0x00, // |
+  0x00, 0x41, 0x36, 0x08, 0x00, // }
+  0x02, 0x01, 0x02, 0x04, 0x02, // ~
+};
+
+static void fb_mark(uint8_t page, uint8_t x) {
+  if (x < fb_dirty_lo[page])
+    fb_dirty_lo[page] = x;
+  if (x > fb_dirty_hi[page])
+    fb_dirty_hi[page] = x;
+}
+
+static void fb_init(void) {
+  // unknown panel content, the first flush sends everything
+  memset(fb, 0xff, sizeof(fb));
+  memset(shown, 0x00, sizeof(shown));
+  for (int page = 0; page < OLED_PAGES; page++) {
+    fb_dirty_lo[page] = 0;
+    fb_dirty_hi[page] = OLED_DISPLAY_WIDTH - 1;
+  }
+}
+
+void fb_clearScreen(oled_color_t color) {
+  memset(fb, color == OLED_COLOR_WHITE ? 0xff : 0x00, sizeof(fb));
+  for (int page = 0; page < OLED_PAGES; page++) {
+    fb_dirty_lo[page] = 0;
+    fb_dirty_hi[page] = OLED_DISPLAY_WIDTH - 1;
+  }
+}
+
+void fb_putPixel(int x, int y, oled_color_t color) {
+  if (x < 0 || x >= OLED_DISPLAY_WIDTH || y < 0 || y >= OLED_DISPLAY_HEIGHT)
+    return;
+  uint8_t page = y >> 3;
+  uint8_t mask = 1 << (y & 7);
+  if (color == OLED_COLOR_WHITE)
+    fb[page][x] |= mask;
+  else
+    fb[page][x] &= ~mask;
+  fb_mark(page, x);
+}
+
+void fb_line(int x0, int y0, int x1, int y1, oled_color_t color) {
+  int dx = abs(x1 - x0);
+  int dy = -abs(y1 - y0);
+  int sx = x0 < x1 ? 1 : -1;
+  int sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+
+  while (1) {
+    fb_putPixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1)
+      break;
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+void fb_circle(int x0, int y0, int r, oled_color_t color) {
+  int f = 1 - r;
+  int ddF_x = 0;
+  int ddF_y = -2 * r;
+  int x = 0;
+  int y = r;
+
+  fb_putPixel(x0, y0 + r, color);
+  fb_putPixel(x0, y0 - r, color);
+  fb_putPixel(x0 + r, y0, color);
+  fb_putPixel(x0 - r, y0, color);
+
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x + 1;
+    fb_putPixel(x0 + x, y0 + y, color);
+    fb_putPixel(x0 - x, y0 + y, color);
+    fb_putPixel(x0 + x, y0 - y, color);
+    fb_putPixel(x0 - x, y0 - y, color);
+    fb_putPixel(x0 + y, y0 + x, color);
+    fb_putPixel(x0 - y, y0 + x, color);
+    fb_putPixel(x0 + y, y0 - x, color);
+    fb_putPixel(x0 - y, y0 - x, color);
+  }
+}
+
+// 6x8 cell per character, same metrics as oled_putString
+void fb_putString(int x, int y, char * str, oled_color_t fg, oled_color_t bg) {
+  while ( * str != '\0' && x + 6 <= OLED_DISPLAY_WIDTH) {
+    uint8_t ch = (uint8_t) * str++;
+    if (ch < 0x20 || ch > 0x7e)
+      ch = ' ';
+    const uint8_t * glyph = & font5x7[(ch - 0x20) * 5];
+    for (int col = 0; col < 6; col++) {
+      uint8_t bits = col < 5 ? glyph[col] : 0;
+      for (int row = 0; row < 8; row++)
+        fb_putPixel(x + col, y + row, (bits >> row) & 1 ? fg : bg);
+    }
+    x += 6;
+  }
+}
+
+static void oled_dc(uint8_t dc) {
+  if (dc)
+    OLED_DATA();
+  else
+    OLED_CMD();
+}
+
+static void oled_xfer_done(void) {
+  uint32_t t = us_now() - oled_xfer_start;
+
+  fb_stats.xfer_us = t;
+  fb_stats.xfer_us_sum += t;
+  if (t > fb_stats.xfer_us_max)
+    fb_stats.xfer_us_max = t;
+}
+
+#if OLED_USE_DMA
+/*
+ * Display refresh through GPDMA. fb_flush() queues one segment per
+ * command and per data span, DMA_IRQHandler starts the next one, so
+ * the CPU only touches the bus when the D/C line has to change.
+ *
+ * The TX channel finishes while the last bytes are still in the SSP
+ * FIFO, so D/C must not change yet. A second channel drains SSP1's
+ * receive side into oled_rx_sink[]; SSP receives the last byte of a
+ * segment only when it has been shifted out completely, so the RX
+ * channel's terminal count marks the end of the segment on the wire.
+ */
+static void oled_dma_seg(void) {
+  oled_seg_t * sg = & oled_segs[oled_seg_pos];
+  GPDMA_Channel_CFG_Type cfg;
+
+  oled_dc(sg->dc);
+
+  cfg.ChannelNum = OLED_RX_DMA_CH;
+  cfg.TransferSize = sg->len;
+  cfg.TransferWidth = 0;
+  cfg.SrcMemAddr = 0;
+  cfg.DstMemAddr = (uintptr_t) oled_rx_sink;
+  cfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+  cfg.SrcConn = GPDMA_CONN_SSP1_Rx;
+  cfg.DstConn = 0;
+  cfg.DMALLI = 0;
+  GPDMA_Setup( & cfg);
+  GPDMA_ChannelCmd(OLED_RX_DMA_CH, ENABLE);
+
+  cfg.ChannelNum = OLED_DMA_CH;
+  cfg.TransferSize = sg->len;
+  cfg.TransferWidth = 0;
+  cfg.SrcMemAddr = (uintptr_t) sg->data;
+  cfg.DstMemAddr = 0;
+  cfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+  cfg.SrcConn = 0;
+  cfg.DstConn = GPDMA_CONN_SSP1_Tx;
+  cfg.DMALLI = 0;
+  GPDMA_Setup( & cfg);
+  GPDMA_ChannelCmd(OLED_DMA_CH, ENABLE);
+}
+
+static void oled_dma_irq(void) {
+  int err = 0;
+
+  if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, OLED_DMA_CH) == SET) {
+    GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, OLED_DMA_CH);
+    err = 1;
+  }
+  if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, OLED_RX_DMA_CH) == SET) {
+    GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, OLED_RX_DMA_CH);
+    err = 1;
+  }
+  // kraj na TX, bajtite se uste se vo SSP
+  if (GPDMA_IntGetStatus(GPDMA_STAT_INTTC, OLED_DMA_CH) == SET)
+    GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, OLED_DMA_CH);
+
+  if (err) {
+    fb_stats.dma_errors++;
+    GPDMA_ChannelCmd(OLED_DMA_CH, DISABLE);
+    GPDMA_ChannelCmd(OLED_RX_DMA_CH, DISABLE);
+  } else if (GPDMA_IntGetStatus(GPDMA_STAT_INTTC, OLED_RX_DMA_CH) == SET) {
+    GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, OLED_RX_DMA_CH);
+  } else {
+    return;
+  }
+
+  if (++oled_seg_pos < oled_seg_n) {
+    oled_dma_seg();
+    return;
+  }
+
+  OLED_CS_OFF();
+  oled_xfer_done();
+  oled_busy = 0;
+}
+
+static void oled_start(void) {
+  oled_busy = 1;
+  oled_seg_pos = 0;
+  oled_xfer_start = us_now();
+  OLED_CS_ON();
+  oled_dma_seg();
+}
+
+// SSP1 i shown[] se slobodni duri koga DMA ke zavrsi
+static void oled_wait(void) {
+  uint32_t t = us_now();
+
+  if (!oled_busy)
+    return;
+  CPU_WAIT_WHILE(oled_busy);
+  fb_stats.cpu_busy_us += us_now() - t;
+}
+#else
+static void oled_send(const uint8_t * data, uint32_t len) {
+  SSP_DATA_SETUP_Type xferConfig;
+
+  xferConfig.tx_data = (void * ) data;
+  xferConfig.rx_data = NULL;
+  xferConfig.length = len;
+
+  OLED_CS_ON();
+  SSP_ReadWrite(LPC_SSP1, & xferConfig, SSP_TRANSFER_POLLING);
+  OLED_CS_OFF();
+}
+
+static void oled_start(void) {
+  oled_xfer_start = us_now();
+  for (int i = 0; i < oled_seg_n; i++) {
+    oled_dc(oled_segs[i].dc);
+    oled_send(oled_segs[i].data, oled_segs[i].len);
+  }
+  oled_xfer_done();
+  fb_stats.cpu_busy_us += fb_stats.xfer_us;
+}
+
+static void oled_wait(void) {}
+#endif
+
+void DMA_IRQHandler(void) {
+  adc_dma_irq();
+#if OLED_USE_DMA
+  oled_dma_irq();
+#endif
+}
+
+// 7seg displejot e na istiot SSP1, se prakja samo ako znakot se menuva
+static void seg_setChar(uint8_t ch) {
+  if (ch == seg_shadow) {
+    out_stats.seg_skipped++;
+    return;
+  }
+  seg_shadow = ch;
+  out_stats.seg_writes++;
+  oled_wait();
+  led7seg_setChar(ch, FALSE);
+}
+
+/*
+ * Sends only the changed columns of each page and returns the byte
+ * count. The data goes out of shown[], so drawing into fb[] can
+ * continue while the previous frame is still on the bus.
+ */
+uint32_t fb_flush(void) {
+  uint32_t bytes = 0;
+
+  oled_wait();
+  oled_seg_n = 0;
+  for (int page = 0; page < OLED_PAGES; page++) {
+    int lo = fb_dirty_lo[page];
+    int hi = fb_dirty_hi[page];
+
+    fb_dirty_lo[page] = OLED_DISPLAY_WIDTH;
+    fb_dirty_hi[page] = 0;
+
+    while (lo <= hi && fb[page][lo] == shown[page][lo])
+      lo++;
+    while (hi >= lo && fb[page][hi] == shown[page][hi])
+      hi--;
+    if (lo > hi)
+      continue;
+
+    uint8_t x = lo + OLED_X_OFFSET;
+    uint8_t * cmd = oled_cmds[page];
+    cmd[0] = 0xb0 | page; // page address
+    cmd[1] = 0x00 | (x & 0x0f); // lower column address
+    cmd[2] = 0x10 | (x >> 4); // higher column address
+    memcpy( & shown[page][lo], & fb[page][lo], hi - lo + 1);
+
+    oled_segs[oled_seg_n].data = cmd;
+    oled_segs[oled_seg_n].len = 3;
+    oled_segs[oled_seg_n].dc = 0;
+    oled_seg_n++;
+    oled_segs[oled_seg_n].data = & shown[page][lo];
+    oled_segs[oled_seg_n].len = hi - lo + 1;
+    oled_segs[oled_seg_n].dc = 1;
+    oled_seg_n++;
+    bytes += 3 + hi - lo + 1;
+  }
+
+  if (oled_seg_n > 0)
+    oled_start();
+
+  fb_stats.frames++;
+  fb_stats.bytes += bytes;
+  fb_stats.last_frame_bytes = bytes;
+  return bytes;
+}
+
+static void window_clear(sample_window_t * w) {
+  w->head = 0;
+  w->count = 0;
+}
+
+static void window_push(sample_window_t * w, int32_t v) {
+  w->values[w->head] = v;
+  if (++w->head == WINDOW_DEPTH)
+    w->head = 0;
+  if (w->count < WINDOW_DEPTH)
+    w->count++;
+}
+
+// i = 0 e najstarata vrednost, i = count - 1 najnovata
+static int32_t window_get(const sample_window_t * w, int i) {
+  int k = w->head - w->count + i;
+  if (k < 0)
+    k += WINDOW_DEPTH;
+  return w->values[k];
+}
+
+void display_working_modes(void) {
+  fb_clearScreen(OLED_COLOR_WHITE);
+  fb_putString(12, 1, "=== MENU ===", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  for (int i = 0; i < MODE_COUNT; i++)
+    fb_putString(20, MENU_ROW(i, MODE_COUNT), mode_names[i], OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  fb_flush();
+}
+
+void display_measurement_options(void) {
+  fb_clearScreen(OLED_COLOR_WHITE);
+  fb_putString(5, 1, "=== SELECT ===", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  for (int ch = 0; ch < CH_COUNT; ch++)
+    fb_putString(15, MENU_ROW(ch, CH_COUNT), channel_names[ch], OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  fb_flush();
+}
+
+/*
+ * The normalize_* functions map a raw reading to a graph height
+ * (10 - 53 pixels). There is no FPU, so the scaling is done in Q20
+ * fixed point with constants folded at compile time.
+ */
+int32_t normalize_temperature(int32_t val) {
+  // ((val / 10 - 15) / 20) * 43 + 10
+  int32_t q = val * TEMP_GAIN + TEMP_OFFSET;
+  if (q < 0)
+    return 0;
+  return q >> NORM_Q;
+}
+
+int32_t normalize_light(int32_t val) {
+  // (val / 4000) * 43 + 10
+  return (val * LIGHT_GAIN + GRAPH_BASE) >> NORM_Q;
+}
+
+int32_t normalize_potentiometer(int32_t val) {
+  // (val / 4095) * 43 + 10
+  return (val * POT_GAIN + GRAPH_BASE) >> NORM_Q;
+}
+
+int32_t normalize_acceleration(int32_t val) {
+  // ((val + 128) / 256) * 43 + 10
+  return ((val + 128) * ACC_GAIN + GRAPH_BASE) >> NORM_Q;
+}
+
+#define X_NORM_CASE(ch, name, rd, norm, bits, bias, led) case ch: return norm(v);
+
+static int32_t normalize_channel(int ch, int32_t v) {
+  switch (ch) {
+    SENSORS(X_NORM_CASE)
+  }
+  return 0;
+}
+
+static int32_t read_temperature(void) {
+  int32_t v = temp_value;
+  temp_request();
+  return v;
+}
+
+static int32_t read_light(void) {
+  int32_t v = light_lux;
+  light_request();
+  return v;
+}
+
+static int32_t read_potentiometer(void) {
+  return adc_average(ADC_AVERAGE);
+}
+
+static int32_t read_acceleration(void) {
+  int32_t v = acc_z;
+  acc_request();
+  return v;
+}
+
+#define X_READ(ch, name, rd, norm, bits, bias, led) v[ch] = rd();
+
+static void read_sensors(int32_t * v) {
+  SENSORS(X_READ)
+}
+
+static void show_modes(void) {
+  display_working_modes();
+  fb_circle(5, MENU_ROW(mode, MODE_COUNT) + 3, 3, OLED_COLOR_BLACK);
+  fb_flush();
+}
+
+static void show_sensors(void) {
+  sel_ch = CH_TEMPERATURE;
+  display_measurement_options();
+  fb_circle(5, MENU_ROW(sel_ch, CH_COUNT) + 3, 3, OLED_COLOR_BLACK);
+  fb_flush();
+}
+
+/*
+ * Every SAMPLE_PERIOD all channels are sampled into history[], whatever
+ * is on screen. The real-time view only picks which one to draw.
+ */
+static void acquire_task(void) {
+  PROF_BEGIN(PRF_SENSORS);
+  read_sensors(raw_latest);
+  PROF_END(PRF_SENSORS);
+
+  for (int ch = 0; ch < CH_COUNT; ch++)
+    tlm_send(ch, raw_latest[ch]);
+
+  PROF_BEGIN(PRF_NORMALIZE);
+#define X_PUSH(ch, name, rd, norm, bits, bias, led) window_push( & history[ch], norm(raw_latest[ch]));
+  SENSORS(X_PUSH)
+  PROF_END(PRF_NORMALIZE);
+
+  if (ui_state == UI_REALTIME) {
+    PROF_BEGIN(PRF_DRAW);
+    draw_graph_real_time(active_window, channel_names[sel_ch]);
+    PROF_END(PRF_DRAW);
+  }
+}
+
+/*
+ * Recording format, version 2: the REC_VERSION nibble followed by
+ * the SENSORS() fields, MSB first, each biased and clamped to its
+ * width. With 12-bit temperature, light and potentiometer and the
+ * 8-bit acceleration this is 6 bytes:
+ *
+ *   vvvvTTTT  TTTTTTTT  LLLLLLLL  LLLLPPPP  PPPPPPPP  AAAAAAAA
+ *
+ * T is in 0.1 C offset by REC_TEMP_OFFSET, L in lux, P the raw ADC
+ * value and A the signed Z axis offset by 128. Erased EEPROM (0xff)
+ * and older versions never decode as valid.
+ */
+typedef struct {
+  uint8_t * b;
+  uint32_t acc;
+  int bits;
+} rec_bits_t;
+
+static void rec_put(rec_bits_t * r, int32_t v, int width) {
+  int32_t max = (1 << width) - 1;
+  if (v < 0)
+    v = 0;
+  if (v > max)
+    v = max;
+
+  r->acc = (r->acc << width) | v;
+  r->bits += width;
+  while (r->bits >= 8) {
+    r->bits -= 8;
+    * r->b++ = r->acc >> r->bits;
+  }
+}
+
+static int32_t rec_get(rec_bits_t * r, int width) {
+  while (r->bits < width) {
+    r->acc = (r->acc << 8) | * r->b++;
+    r->bits += 8;
+  }
+  r->bits -= width;
+  return (r->acc >> r->bits) & ((1 << width) - 1);
+}
+
+#define X_ENCODE(ch, name, rd, norm, bits, bias, led) rec_put( & r, v[ch] + (bias), bits);
+#define X_DECODE(ch, name, rd, norm, bits, bias, led) v[ch] = rec_get( & r, bits) - (bias);
+
+static void record_encode(uint8_t * b, const int32_t * v) {
+  rec_bits_t r = { b, 0, 0 };
+
+  rec_put( & r, REC_VERSION, 4);
+  SENSORS(X_ENCODE)
+  if (r.bits > 0)
+    * r.b = r.acc << (8 - r.bits);
+}
+
+static int record_decode(const uint8_t * b, int32_t * v) {
+  rec_bits_t r = { (uint8_t * ) b, 0, 0 };
+
+  if (rec_get( & r, 4) != REC_VERSION)
+    return 0;
+  SENSORS(X_DECODE)
+  return 1;
+}
+
+static uint16_t store_next(uint16_t page) {
+  return page + 1 == STORE_PAGES ? 0 : page + 1;
+}
+
+static uint16_t store_prev(uint16_t page) {
+  return page == 0 ? STORE_PAGES - 1 : page - 1;
+}
+
+static uint16_t header_seq(const uint8_t * h) {
+  return h[0] | (h[1] << 8);
+}
+
+static uint16_t crc16(const uint8_t * b, uint8_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= * b++ << 8;
+    for (int i = 0; i < 8; i++)
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+static int store_header_ok(const uint8_t * h) {
+  return crc16(h, 4, 0xffff) == (h[4] | (h[5] << 8));
+}
+
+static int store_header(uint16_t page, uint8_t * h) {
+  eeprom_read(h, page * EEPROM_PAGE_SIZE, STORE_HEADER_SIZE);
+  return store_header_ok(h);
+}
 
-void SysTick_Handler(void) {
-  msTicks++;
+// cela strana, vrakja 0 ako zaglavieto e prazno ili skinato
+static int store_read_page(uint16_t page, uint8_t * pg) {
+  eeprom_read(pg, page * EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE);
+  return store_header_ok(pg);
 }
 
-static uint32_t getTicks(void) {
-  return msTicks;
+// seq na stranata vleguva vo CRC na delot
+static uint16_t chunk_crc(const uint8_t * pg, uint8_t at, uint8_t n) {
+  return crc16( & pg[at], 1 + n * REC_SIZE, crc16(pg, 2, 0xffff));
 }
 
-static void init_ssp(void) {
-  SSP_CFG_Type SSP_ConfigStruct;
-  PINSEL_CFG_Type PinCfg;
+// dolzina na validniot del na at, 0 ako tamu nema
+static uint8_t chunk_len(const uint8_t * pg, uint8_t at) {
+  uint8_t n = pg[at] & STORE_COUNT_MASK;
+  uint8_t len = STORE_CHUNK_SIZE(n);
 
-  /*
-   * Initialize SPI pin connect
-   * P0.7 - SCK;
-   * P0.8 - MISO
-   * P0.9 - MOSI
-   * P2.2 - SSEL - used as GPIO
-   */
-  PinCfg.Funcnum = 2;
-  PinCfg.OpenDrain = 0;
-  PinCfg.Pinmode = 0;
-  PinCfg.Portnum = 0;
-  PinCfg.Pinnum = 7;
-  PINSEL_ConfigPin( & PinCfg);
-  PinCfg.Pinnum = 8;
-  PINSEL_ConfigPin( & PinCfg);
-  PinCfg.Pinnum = 9;
-  PINSEL_ConfigPin( & PinCfg);
-  PinCfg.Funcnum = 0;
-  PinCfg.Portnum = 2;
-  PinCfg.Pinnum = 2;
-  PINSEL_ConfigPin( & PinCfg);
+  if (at + STORE_CHUNK_SIZE(0) > EEPROM_PAGE_SIZE || n > STORE_RECS_PER_PAGE || at + len > EEPROM_PAGE_SIZE)
+    return 0;
+  if (chunk_crc(pg, at, n) != (pg[at + len - 2] | (pg[at + len - 1] << 8)))
+    return 0;
+  return len;
+}
 
-  SSP_ConfigStructInit( & SSP_ConfigStruct);
+// gi sobira zapisite i znamiinjata od validnite delovi na stranata
+static void store_scan(const uint8_t * pg, uint16_t * recs, uint8_t * flags) {
+  uint8_t len;
 
-  // Initialize SSP peripheral with parameter given in structure above
-  SSP_Init(LPC_SSP1, & SSP_ConfigStruct);
+  for (uint8_t at = STORE_HEADER_SIZE; (len = chunk_len(pg, at)) > 0; at += len) {
+    * recs += pg[at] & STORE_COUNT_MASK;
+    * flags |= pg[at] & ~STORE_COUNT_MASK;
+  }
+}
 
-  // Enable SSP peripheral
-  SSP_Cmd(LPC_SSP1, ENABLE);
+// nanazad od page dodeka sesijata e ista i seq posledovatelen, najmnogu max strani
+static uint16_t store_session_walk(uint16_t page, uint16_t seq, uint8_t session, uint16_t max, uint16_t * pages) {
+  uint8_t h[STORE_HEADER_SIZE];
 
+  * pages = 0;
+  while ( * pages < max && store_header(page, h) && h[2] == session && header_seq(h) == seq) {
+    ( * pages)++;
+    page = store_prev(page);
+    seq--;
+  }
+  return store_next(page);
 }
 
-static void init_i2c(void) {
-  PINSEL_CFG_Type PinCfg;
+// prvata strana od sesijata na glavata, i kolku strani ima taa
+static uint16_t store_session_start(uint16_t * pages) {
+  return store_session_walk(store.head, store.seq, store.session, STORE_PAGES, pages);
+}
 
-  /* Initialize I2C2 pin connect */
-  PinCfg.Funcnum = 2;
-  PinCfg.Pinnum = 10;
-  PinCfg.Portnum = 0;
-  PINSEL_ConfigPin( & PinCfg);
-  PinCfg.Pinnum = 11;
-  PINSEL_ConfigPin( & PinCfg);
+/*
+ * Earlier sessions sit right behind the start of the one after them:
+ * the page before it carries the previous seq and another session
+ * number. Walking back stops at a gap in seq (erased or torn page,
+ * leftovers of the previous lap) or once the whole ring is covered;
+ * the oldest session may have lost its first pages to the new lap.
+ * Returns STORE_PAGES when there is no session that far back.
+ */
+static uint16_t store_session_back(uint8_t back, uint16_t * pages) {
+  uint8_t h[STORE_HEADER_SIZE];
+  uint16_t page = store_session_start(pages);
+  uint16_t seq = store.seq - * pages + 1; // seq na prvata strana
+  uint16_t seen = * pages;
+
+  for (; back > 0; back--) {
+    uint16_t prev = store_prev(page);
+    if (seen >= STORE_PAGES || !store_header(prev, h) || header_seq(h) != (uint16_t)(seq - 1))
+      return STORE_PAGES;
+    page = store_session_walk(prev, seq - 1, h[2], STORE_PAGES - seen, pages);
+    seq -= * pages;
+    seen += * pages;
+  }
+  return page;
+}
 
-  // Initialize I2C peripheral
-  I2C_Init(LPC_I2C2, 100000);
+/*
+ * Recovery after reset. Starting from page 0, pages with a valid
+ * header carry consecutive sequence numbers up to the head; whatever
+ * follows is erased, torn or left over from the previous lap. That
+ * makes the head a binary search over a handful of header reads. The
+ * chunks of the head's session say whether it was committed; if not,
+ * its records are counted so the recording can pick up where it was
+ * cut, on the next page.
+ */
+static void store_init(void) {
+  uint8_t pg[EEPROM_PAGE_SIZE];
+  uint16_t lo = 0;
+  uint16_t hi = STORE_PAGES;
+  uint16_t pages;
+  uint8_t flags = 0;
+
+  store.empty = 1;
+  store.open = 0;
+  store.pending = 0;
+  store.head = STORE_PAGES - 1;
+  store.seq = 0;
+  store.session = 0;
+  store.info = 0;
+  store.session_recs = 0;
+  store.committed = 1;
+  store.resume = 0;
+
+  if (!store_header(0, pg)) {
+    // page 0 torn while wrapping: the previous lap ends on the last page
+    if (!store_header(1, pg) || !store_header(STORE_PAGES - 1, pg))
+      return;
+    lo = STORE_PAGES - 1;
+  } else {
+    uint16_t s0 = header_seq(pg);
+    while (hi - lo > 1) {
+      uint16_t mid = (lo + hi) / 2;
+      if (store_header(mid, pg) && header_seq(pg) == (uint16_t)(s0 + mid))
+        lo = mid;
+      else
+        hi = mid;
+    }
+    store_header(lo, pg);
+  }
 
-  /* Enable I2C1 operation */
-  I2C_Cmd(LPC_I2C2, ENABLE);
+  store.empty = 0;
+  store.head = lo;
+  store.seq = header_seq(pg);
+  store.session = pg[2];
+  store.info = pg[3] & ~STORE_RESUMED;
+
+  uint16_t page = store_session_start( & pages);
+  for (; pages > 0; pages--, page = store_next(page))
+    if (store_read_page(page, pg))
+      store_scan(pg, & store.session_recs, & flags);
+  store.committed = (flags & STORE_COMMIT) != 0;
+  store.resume = !store.committed && (store.info & STORE_PERIOD_MASK) != STORE_NO_PERIOD;
+  LOG(LOG_STORE_RECOVER, store.head, store.seq, store.session, store.committed);
 }
 
-static void init_adc(void) {
-  PINSEL_CFG_Type PinCfg;
+static void store_open_page(void) {
+  store.head = store_next(store.head);
+  store.seq++;
+  store.page[0] = store.seq & 0xff;
+  store.page[1] = store.seq >> 8;
+  store.page[2] = store.session;
+  store.page[3] = store.info;
+  uint16_t crc = crc16(store.page, 4, 0xffff);
+  store.page[4] = crc & 0xff;
+  store.page[5] = crc >> 8;
+  store.fill = 0; // zaglavieto odi so prviot del
+  store.empty = 0;
+  store.open = 1;
+}
 
-  /*
-   * Init ADC pin connect
-   * AD0.0 on P0.23
-   */
-  PinCfg.Funcnum = 1;
-  PinCfg.OpenDrain = 0;
-  PinCfg.Pinmode = 0;
-  PinCfg.Pinnum = 23;
-  PinCfg.Portnum = 0;
-  PINSEL_ConfigPin( & PinCfg);
+// kade pocnuva sledniot del
+static uint8_t store_at(void) {
+  return store.fill ? store.fill : STORE_HEADER_SIZE;
+}
 
-  /* Configuration for ADC :
-   * 	Frequency at 0.2Mhz
-   *  ADC channel 0, no Interrupt
-   */
-  ADC_Init(LPC_ADC, 200000);
-  ADC_IntConfig(LPC_ADC, ADC_CHANNEL_0, DISABLE);
-  ADC_ChannelCmd(LPC_ADC, ADC_CHANNEL_0, ENABLE);
+// kolku uste zapisi sobira stranata pokraj tie sto cekaat
+static int store_room(void) {
+  return ((int) EEPROM_PAGE_SIZE - store_at() - STORE_CHUNK_SIZE(0)) / REC_SIZE - store.pending;
+}
 
+/*
+ * The records waiting in store.page go out as one chunk. The first
+ * chunk of a page takes the header with it, later ones write only
+ * their own bytes, so nothing that is already on the EEPROM is written
+ * again and a torn write can only lose the chunk being written.
+ */
+static void store_flush(uint8_t flags) {
+  if (!store.open || (store.pending == 0 && flags == 0))
+    return;
+
+  PROF_BEGIN(PRF_EEPROM);
+  uint8_t at = store_at();
+  uint8_t len = STORE_CHUNK_SIZE(store.pending);
+  store.page[at] = store.pending | flags;
+  uint16_t crc = chunk_crc(store.page, at, store.pending);
+  store.page[at + len - 2] = crc & 0xff;
+  store.page[at + len - 1] = crc >> 8;
+  eeprom_write_async( & store.page[store.fill], store.head * EEPROM_PAGE_SIZE + store.fill,
+    at + len - store.fill);
+  PROF_END(PRF_EEPROM);
+
+  store.fill = at + len;
+  store.pending = 0;
+  store.page_writes++;
+  store.wear[store.head]++;
+  timer_stop(TMR_STORE);
 }
 
-void display_working_modes(void) {
-  oled_clearScreen(OLED_COLOR_WHITE);
-  oled_putString(12, 1, "=== MENU ===", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-  oled_putString(20, 19, "Real time", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-  oled_putString(20, 34, "Save", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-  oled_putString(20, 49, "Show saved", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+static void store_flush_task(void) {
+  store_flush(0);
 }
 
-void display_measurement_options(void) {
-  oled_clearScreen(OLED_COLOR_WHITE);
-  oled_putString(5, 1, "=== SELECT ===", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-  oled_putString(15, 19, "Temperature", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-  oled_putString(15, 34, "Light", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-  oled_putString(15, 49, "Potentiometer", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+// nova sesija, na nova strana; period e indeks vo rec_periods[] ili STORE_NO_PERIOD
+static void store_begin(uint8_t period) {
+  store.session++;
+  store.info = period;
+  store.open = 0;
+  store.pending = 0;
+  store.session_recs = 0;
+  store.committed = 0;
+  store.resume = 0;
 }
 
-uint32_t normalize_temperature(uint32_t val) {
-  double new_val = (double) val;
-  new_val = new_val / 10;
-  new_val = (((new_val - 15) / 20) * 43) + 10;
-  return (uint32_t) new_val;
+// prekinatata sesija prodolzuva na sledna strana, zad skinatiot zapis
+static void store_resume(void) {
+  store.info |= STORE_RESUMED;
+  store.open = 0;
+  store.resume = 0;
 }
 
-uint32_t normalize_light(uint32_t val) {
-  double new_val = (double) val;
-  new_val = ((new_val / 4000) * 43) + 10;
-  return (uint32_t) new_val;
+/*
+ * Records wait in RAM until the page is full or for at most
+ * STORE_FLUSH_MS, so fast recordings still write whole pages and a
+ * reset loses at most the last second.
+ */
+static void store_put(const uint8_t * rec) {
+  if (!store.open || store_room() <= 0)
+    store_open_page();
+  memcpy( & store.page[store_at() + 1 + store.pending * REC_SIZE], rec, REC_SIZE);
+  if (store.pending++ == 0)
+    timer_start(TMR_STORE, store_flush_task, STORE_FLUSH_MS, 0);
+  store.record_bytes += REC_SIZE;
+  store.session_recs++;
+  if (store_room() == 0)
+    store_flush(0);
 }
 
-uint32_t normalize_potentiometer(uint32_t val) {
-  double new_val = (double) val;
-  new_val = ((new_val / 4095) * 43) + 10;
-  return (uint32_t) new_val;
+// posleden del so STORE_COMMIT, i bez zapisi ako nema sto da ceka
+static void store_commit(void) {
+  if (store.session_recs == 0)
+    return; // sesijata nema zapisi
+  if (!store.open || (store.pending == 0 && store_at() + STORE_CHUNK_SIZE(0) > EEPROM_PAGE_SIZE))
+    store_open_page();
+  store_flush(STORE_COMMIT);
+  store.open = 0;
+  store.committed = 1;
 }
 
-void measure_temperature(void) {
-  int32_t t = 0;
-  int i = 0;
-  while (1) {
-    if (i >= 13) {
-      for (int j = 0; j < 12; j++)
-        temperatures[j] = temperatures[j + 1];
-      i--;
-    }
-    btn1 = ((GPIO_ReadValue(0) >> 4) & 0x01);
-    if (btn1 == 0)
-      break;
-    t = temp_read();
-    temperatures[i] = normalize_temperature(t);
-    if (i < 13)
-      i++;
-    draw_graph_real_time(temperatures, i, "Temperature");
-    Timer0_Wait(200);
-  }
-  display_working_modes();
-  btn1 = 1;
+/*
+ * Whole-recording view. procitaj() streams the records of a session
+ * through env_push() in one pass, however long the session is: each
+ * record goes into the bucket for its index, and when the ENV_BUCKETS
+ * are full, neighbouring buckets are merged in pairs and every bucket
+ * covers twice as many records from then on. env_render() folds the
+ * buckets onto the pixel columns and draws the frame, so its cost does
+ * not depend on the length of the session.
+ */
+static void env_add(env_t * e, int32_t min, int32_t max, int32_t sum, uint16_t n) {
+  if (e->n == 0 || min < e->min)
+    e->min = min;
+  if (e->n == 0 || max > e->max)
+    e->max = max;
+  e->sum += sum;
+  e->n += n;
 }
 
-void measure_light(void) {
-  int32_t l = 0;
-  int i = 0;
-  while (1) {
-    if (i >= 13) {
-      for (int j = 0; j < 12; j++)
-        lights[j] = lights[j + 1];
-      i--;
+static void env_begin(void) {
+  memset(env_cols, 0, sizeof(env_cols));
+  env_stride = 1;
+  env_count = 0;
+}
+
+static void env_push(int32_t v) {
+  if (env_count / env_stride == ENV_BUCKETS) {
+    for (int k = 0; k < ENV_BUCKETS / 2; k++) {
+      env_t e = env_cols[2 * k + 1];
+      env_cols[k] = env_cols[2 * k];
+      env_add( & env_cols[k], e.min, e.max, e.sum, e.n);
     }
-    btn1 = ((GPIO_ReadValue(0) >> 4) & 0x01);
-    if (btn1 == 0)
-      break;
-    l = light_read();
-    lights[i] = normalize_light(l);
-    if (i < 13)
-      i++;
-    draw_graph_real_time(lights, i, "Light");
-    Timer0_Wait(200);
+    memset( & env_cols[ENV_BUCKETS / 2], 0, sizeof(env_cols) / 2);
+    env_stride *= 2;
   }
-  display_working_modes();
-  btn1 = 1;
+  env_add( & env_cols[env_count / env_stride], v, v, v, 1);
+  env_count++;
 }
 
-void measure_potentiometer(void) {
-  int32_t t = 0;
+// gi cita zapisite od sesijata back pred poslednata vo env_cols[] i measures, vrakja kolku validni zapisi ima
+int procitaj(int ch, uint8_t back) {
+  uint8_t pg[EEPROM_PAGE_SIZE];
+  int32_t v[CH_COUNT];
+  uint16_t pages;
+  uint8_t len;
   int i = 0;
-  while (1) {
-    if (i >= 13) {
-      for (int j = 0; j < 12; j++)
-        potentiometers[j] = potentiometers[j + 1];
-      i--;
-    }
-    btn1 = ((GPIO_ReadValue(0) >> 4) & 0x01);
-    if (btn1 == 0)
+
+  saved_committed = 0;
+  saved_resumed = 0;
+  env_begin();
+  window_clear( & measures);
+  if (store.empty)
+    return 0;
+
+  i2c_sync();
+  uint16_t page = store_session_back(back, & pages);
+  if (page == STORE_PAGES)
+    return 0;
+  for (; pages > 0; pages--, page = store_next(page)) {
+    if (!store_read_page(page, pg))
       break;
-    ADC_StartCmd(LPC_ADC, ADC_START_NOW);
-    //Wait conversion complete
-    while (!(ADC_ChannelGetStatus(LPC_ADC, ADC_CHANNEL_0, ADC_DATA_DONE)));
-    uint32_t p = ADC_ChannelGetData(LPC_ADC, ADC_CHANNEL_0);
-    potentiometers[i] = normalize_potentiometer(p);
-    if (i < 13)
-      i++;
-    draw_graph_real_time(potentiometers, i, "Potentiometer");
-    Timer0_Wait(200);
+    if (pg[3] & STORE_RESUMED)
+      saved_resumed = 1;
+
+    for (uint8_t at = STORE_HEADER_SIZE; (len = chunk_len(pg, at)) > 0; at += len) {
+      if (pg[at] & STORE_COMMIT)
+        saved_committed = 1;
+      for (int k = 0; k < (pg[at] & STORE_COUNT_MASK); k++) {
+        if (!record_decode( & pg[at + 1 + k * REC_SIZE], v))
+          return i;
+        int32_t x = normalize_channel(ch, v[ch]);
+        env_push(x);
+        window_push( & measures, x); // LED lentata ja pokazuva poslednata vrednost
+        tlm_send(TLM_REPLAY, x);
+        i++;
+      }
+    }
   }
-  display_working_modes();
-  btn1 = 1;
+
+  return i;
 }
 
-void procitaj(int sto) {
-  uint16_t dolzina_zapis = 11;
-  int mem = 0;
-  int br = 90;
-  int i = 0;
-  uint16_t offset = 0;
-  int l = 0;
+// kofite od env_push() vo prvite OLED_DISPLAY_WIDTH, pa crtanje
+static void env_render(char * title) {
+  int used = (env_count + env_stride - 1) / env_stride;
 
-  switch (sto) {
-  case 1:
-    offset = 0;
-    l = 3;
-    break;
-  case 2:
-    offset = 3;
-    l = 4;
-    break;
-  case 3:
-    offset = 7;
-    l = 4;
-    break;
+  // kofata c odi na kolonata c * 96 / used <= c, pa moze na isto mesto
+  for (int c = 0; c < used; c++) {
+    env_t e = env_cols[c];
+    memset( & env_cols[c], 0, sizeof(env_t));
+    env_add( & env_cols[c * OLED_DISPLAY_WIDTH / used], e.min, e.max, e.sum, e.n);
   }
 
-  uint8_t buf[11];
-
-  int minute[br];
-  for (i = 0; i < br; i++) {
-    eeprom_read(buf, i * dolzina_zapis, dolzina_zapis);
-    char subbuff[5];
-    memcpy(subbuff, & buf[offset], l);
-    subbuff[4] = '\0';
-    printf("%d. Citanje:%s\n", i, subbuff);
-    //		int v = atoi(subbuff);
-    char temp[3] = {
-      subbuff[2],
-      subbuff[3],
-      '\0'
-    };
-    long v = strtol(temp, NULL, 10);
-    minute[i] = v;
-    zapisani[i] = v;
+  fb_clearScreen(OLED_COLOR_WHITE);
+  fb_putString(12, 1, title, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  int px = -1, py = 0;
+  for (int x = 0; x < OLED_DISPLAY_WIDTH; x++) {
+    env_t * e = & env_cols[x];
+    if (e->n == 0)
+      continue;
+    int y = 64 - e->sum / e->n;
+    fb_line(x, 64 - e->max, x, 64 - e->min, OLED_COLOR_BLACK);
+    if (px >= 0)
+      fb_line(px, py, x, y, OLED_COLOR_BLACK);
+    px = x;
+    py = y;
   }
+  fb_flush();
+}
 
+// sesijata saved_back, naslovot kazuva kolku e nanazad
+static void show_saved(void) {
+  char title[16];
+  char * kind;
+
+  saved_count = procitaj(sel_ch, saved_back);
+  if (saved_count == 0)
+    return;
+  kind = !saved_committed ? "Cut" : saved_resumed ? "Resumed" : "Saved";
+  if (saved_back == 0)
+    snprintf(title, sizeof(title), "%s data:", kind);
+  else
+    snprintf(title, sizeof(title), "%s -%u:", kind, (unsigned) saved_back);
+  env_render(title);
 }
 
-void displaySaved(void) {
-  procitaj(measurement_option);
-  int c = 0;
-  int br = 90;
-  int i = 0;
+static void start_view(void) {
+  if (mode == MODE_REALTIME) {
+    active_window = & history[sel_ch];
+    ui_state = UI_REALTIME;
+    if (active_window->count > 0)
+      draw_graph_real_time(active_window, channel_names[sel_ch]);
+  } else {
+    saved_back = 0;
+    show_saved();
+    active_window = & measures;
+    ui_state = UI_SAVED;
+  }
+  timer_start(TMR_LEDS, led_task, LED_PERIOD, LED_PERIOD);
+}
 
-  while (1) {
-    printf("c:%d\n", c);
+static void stop_view(void) {
+  timer_stop(TMR_LEDS);
+  active_window = NULL;
+}
 
-    if (i >= 13) {
-      for (int j = 0; j < 12; j++)
-        measures[j] = measures[j + 1];
-      i--;
-    }
-    //ovde treba da dodademe vrednost od nizata
-    measures[i] = zapisani[c];
-
-    if (c >= br) break;
-    c++;
-    if (i < 13) {
-      i++;
-      draw_graph_real_time(measures, i, "Saved data:");
+// cel koren, bez FPU
+static uint32_t isqrt(uint32_t v) {
+  uint32_t r = 0;
+  uint32_t bit = 1 << 30;
+
+  while (bit > v)
+    bit >>= 2;
+  while (bit) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
     }
+    bit >>= 2;
   }
+  return r;
 }
 
-void display_menu(void) {
-  measurement_option = 1;
-  display_measurement_options();
-  oled_circle(5, 22, 3, OLED_COLOR_BLACK);
-  while (1) {
-    btn2 = ((GPIO_ReadValue(1) >> 31) & 0x01);
-    Timer0_Wait(200);
-    if (btn2 == 0) {
-      btn2 = 1;
-      switch (measurement_option) {
-      case 1:
-        if (mode == 1) {
-          measure_temperature();
-          break;
-        } else {
-          displaySaved();
-        }
-      case 2:
-        if (mode == 1) {
-          measure_light();
-          break;
-        } else {
-          displaySaved();
-        }
-      case 0:
-        if (mode == 1) {
-          measure_potentiometer();
-          break;
-        } else {
-          displaySaved();
-        }
-      }
-      break;
-    }
-    btn1 = ((GPIO_ReadValue(0) >> 4) & 0x01);
-    Timer0_Wait(200);
-    if (btn1 == 0) {
-      measurement_option++;
-      btn1 = 1;
-      switch (measurement_option) {
-      case 1:
-        oled_circle(5, 52, 3, OLED_COLOR_WHITE);
-        oled_circle(5, 22, 3, OLED_COLOR_BLACK);
-        break;
-      case 2:
-        oled_circle(5, 22, 3, OLED_COLOR_WHITE);
-        oled_circle(5, 37, 3, OLED_COLOR_BLACK);
-        break;
-      case 3:
-        measurement_option = 0;
-        oled_circle(5, 37, 3, OLED_COLOR_WHITE);
-        oled_circle(5, 52, 3, OLED_COLOR_BLACK);
-        break;
-      }
-      Timer0_Wait(2000);
+static void init_capture(void) {
+  TIM_TIMERCFG_Type TIM_ConfigStruct;
+  TIM_MATCHCFG_Type TIM_MatchConfigStruct;
+
+  TIM_ConfigStruct.PrescaleOption = TIM_PRESCALE_USVAL;
+  TIM_ConfigStruct.PrescaleValue = 1;
+  TIM_Init(LPC_TIM1, TIM_TIMER_MODE, & TIM_ConfigStruct);
+
+  TIM_MatchConfigStruct.MatchChannel = 0;
+  TIM_MatchConfigStruct.IntOnMatch = TRUE;
+  TIM_MatchConfigStruct.ResetOnMatch = TRUE;
+  TIM_MatchConfigStruct.StopOnMatch = FALSE;
+  TIM_MatchConfigStruct.ExtMatchOutputType = TIM_EXTMATCH_NOTHING;
+  TIM_MatchConfigStruct.MatchValue = CAP_PERIOD_US;
+  TIM_ConfigMatch(LPC_TIM1, & TIM_MatchConfigStruct);
+
+  NVIC_EnableIRQ(TIMER1_IRQn);
+}
+
+void TIMER1_IRQHandler(void) {
+  TIM_ClearIntPending(LPC_TIM1, TIM_MR0_INT);
+  cap_tick();
+}
+
+static void cap_draw(void) {
+  char line[20];
+
+  fb_clearScreen(OLED_COLOR_WHITE);
+  fb_putString(1, 1, "Vibration", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  snprintf(line, sizeof(line), "mag  %u mg", (unsigned) cap_stats.mag);
+  fb_putString(1, 17, line, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  snprintf(line, sizeof(line), "peak %u mg", (unsigned) cap_stats.peak);
+  fb_putString(1, 27, line, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  snprintf(line, sizeof(line), "%u/s drop %u", (unsigned) cap_stats.rate,
+    (unsigned)(cap_stats.skipped + cap_stats.failed + cap_stats.overruns + cap_stats.lost));
+  fb_putString(1, 37, line, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  if (cap_store)
+    snprintf(line, sizeof(line), "rec %d/%d", rec_n, REC_COUNT);
+  else
+    snprintf(line, sizeof(line), "SW4 - record");
+  fb_putString(1, 49, line, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  fb_flush();
+}
+
+/*
+ * Every CAP_SHOW_PERIOD: drain cap_buf, update magnitude, peak and
+ * rate, and when recording store the block as one record whose
+ * acceleration field is the Z sample farthest from zero.
+ */
+static void cap_task(void) {
+  uint32_t head = cap_head;
+  uint32_t now = msTicks;
+  int32_t z = 0;
+
+  if (head - cap_tail > CAP_BUF_SIZE) {
+    cap_stats.lost += head - cap_tail - CAP_BUF_SIZE;
+    cap_tail = head - CAP_BUF_SIZE;
+  }
+  for (; cap_tail != head; cap_tail++) {
+    acc_sample_t * s = & cap_buf[cap_tail & (CAP_BUF_SIZE - 1)];
+    uint32_t sq = s->x * s->x + s->y * s->y + s->z * s->z;
+
+    // << 8 za cetiri bita poveke vo korenot
+    cap_stats.mag = isqrt(sq << 8) * 1000 / (ACC_LSB_PER_G << 4);
+    if (cap_stats.mag > cap_stats.peak)
+      cap_stats.peak = cap_stats.mag;
+    if (abs(s->z) > abs(z))
+      z = s->z;
+  }
+
+  if (now - cap_rate_at >= 1000) {
+    cap_stats.rate = (cap_stats.samples - cap_rate_n) * 1000 / (now - cap_rate_at);
+    cap_rate_at = now;
+    cap_rate_n = cap_stats.samples;
+  }
+
+  if (cap_store) {
+    int32_t v[CH_COUNT];
+
+    memcpy(v, raw_latest, sizeof(v));
+    v[CH_ACCELERATION] = z;
+    tlm_send(TLM_RECORD, rec_n);
+    zapisi(v);
+    rec_n++;
+    if (rec_n >= REC_COUNT) {
+      record_finish();
+      cap_store = 0;
     }
   }
+  cap_draw();
+}
+
+static void cap_start(void) {
+  memset( & cap_stats, 0, sizeof(cap_stats));
+  cap_tail = cap_head;
+  cap_rate_at = msTicks;
+  cap_rate_n = 0;
+  cap_store = 0;
+
+  acc_write(ACC_REG_CTL1, ACC_CTL1_DFBW);
+  TIM_ResetCounter(LPC_TIM1);
+  TIM_Cmd(LPC_TIM1, ENABLE);
+  timer_start(TMR_CAPTURE, cap_task, CAP_SHOW_PERIOD, CAP_SHOW_PERIOD);
+  cap_draw();
+  ui_state = UI_CAPTURE;
+}
+
+static void cap_stop(void) {
+  timer_stop(TMR_CAPTURE);
+  TIM_Cmd(LPC_TIM1, DISABLE);
+  if (cap_store)
+    record_finish();
+  cap_store = 0;
+  acc_write(ACC_REG_CTL1, 0);
+  LOG(LOG_CAPTURE, cap_stats.samples, cap_stats.skipped, cap_stats.failed, cap_stats.overruns, cap_stats.lost);
 }
 
 static void change7Seg() {
   if (ch7seg > '9')
     ch7seg = '1';
-  led7seg_setChar(ch7seg, FALSE);
+  seg_setChar(ch7seg);
+}
+
+static void show_period(void) {
+  char line[20];
+  uint32_t ms = rec_periods[ch7seg - '1'];
+
+  if (ms >= 60000)
+    snprintf(line, sizeof(line), "Period: %u min", (unsigned)(ms / 60000));
+  else if (ms >= 1000)
+    snprintf(line, sizeof(line), "Period: %u s", (unsigned)(ms / 1000));
+  else
+    snprintf(line, sizeof(line), "Period: %u ms", (unsigned) ms);
+
+  fb_clearScreen(OLED_COLOR_WHITE);
+  fb_putString(1, 1, "Choose time!", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  fb_putString(1, 17, line, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  fb_flush();
 }
 
 static uint32_t notes[] = {
@@ -387,28 +2627,53 @@ static uint32_t notes[] = {
   1275, // g - 784 Hz
 };
 
-static void playNote(uint32_t note, uint32_t durationMs) {
-
-  uint32_t t = 0;
-
-  if (note > 0) {
-
-    while (t < (durationMs * 1000)) {
-      NOTE_PIN_HIGH();
-      Timer0_us_Wait(note / 2);
-      //delay32Us(0, note / 2);
-
-      NOTE_PIN_LOW();
-      Timer0_us_Wait(note / 2);
-      //delay32Us(0, note / 2);
-
-      t += note;
-    }
+/*
+ * TIMER2 counts microseconds and toggles the speaker pin on every
+ * match, so a note plays in the background at note / 2 us per half
+ * period without keeping the CPU busy.
+ */
+static void init_tone(void) {
+  TIM_TIMERCFG_Type TIM_ConfigStruct;
+  TIM_MATCHCFG_Type TIM_MatchConfigStruct;
+
+  GPIO_SetDir(0, 1 << 26, 1);
+
+  TIM_ConfigStruct.PrescaleOption = TIM_PRESCALE_USVAL;
+  TIM_ConfigStruct.PrescaleValue = 1;
+  TIM_Init(LPC_TIM2, TIM_TIMER_MODE, & TIM_ConfigStruct);
+
+  TIM_MatchConfigStruct.MatchChannel = 0;
+  TIM_MatchConfigStruct.IntOnMatch = TRUE;
+  TIM_MatchConfigStruct.ResetOnMatch = TRUE;
+  TIM_MatchConfigStruct.StopOnMatch = FALSE;
+  TIM_MatchConfigStruct.ExtMatchOutputType = TIM_EXTMATCH_NOTHING;
+  TIM_MatchConfigStruct.MatchValue = notes[0] / 2;
+  TIM_ConfigMatch(LPC_TIM2, & TIM_MatchConfigStruct);
+
+  NVIC_EnableIRQ(TIMER2_IRQn);
+}
 
+void TIMER2_IRQHandler(void) {
+  TIM_ClearIntPending(LPC_TIM2, TIM_MR0_INT);
+  if (tone_high) {
+    NOTE_PIN_LOW();
   } else {
-    Timer0_Wait(durationMs);
-    //delay32Ms(0, durationMs);
+    NOTE_PIN_HIGH();
   }
+  tone_high = !tone_high;
+}
+
+static void tone_start(uint32_t note) {
+  TIM_Cmd(LPC_TIM2, DISABLE);
+  TIM_ResetCounter(LPC_TIM2);
+  TIM_UpdateMatchValue(LPC_TIM2, 0, note / 2);
+  TIM_Cmd(LPC_TIM2, ENABLE);
+}
+
+static void tone_stop(void) {
+  TIM_Cmd(LPC_TIM2, DISABLE);
+  NOTE_PIN_LOW();
+  tone_high = 0;
 }
 
 static uint32_t getNote(uint8_t ch) {
@@ -445,10 +2710,17 @@ static uint32_t getPause(uint8_t ch) {
   }
 }
 
-static void playSong(uint8_t * song) {
+static void song_step(void);
+
+// krajot na tonot, pauza pa sledniot ton
+static void song_rest(void) {
+  tone_stop();
+  timer_start(TMR_SONG, song_step, song_pause, 0);
+}
+
+static void song_step(void) {
   uint32_t note = 0;
   uint32_t dur = 0;
-  uint32_t pause = 0;
 
   /*
    * A song is a collection of tones where each tone is
@@ -457,140 +2729,464 @@ static void playSong(uint8_t * song) {
    * "E2,F4,"
    */
 
-  while ( * song != '\0') {
-    note = getNote( * song++);
-    if ( * song == '\0')
-      break;
-    dur = getDuration( * song++);
-    if ( * song == '\0')
-      break;
-    pause = getPause( * song++);
+  if (song_pos[0] == '\0' || song_pos[1] == '\0' || song_pos[2] == '\0') {
+    song_pos = NULL;
+    return;
+  }
+  note = getNote( * song_pos++);
+  dur = getDuration( * song_pos++);
+  song_pause = getPause( * song_pos++);
 
-    playNote(note, dur);
-    //delay32Ms(0, pause);
-    Timer0_Wait(pause);
+  if (note > 0)
+    tone_start(note);
+  timer_start(TMR_SONG, song_rest, dur, 0);
+}
 
-  }
+// ja pocnuva pesnata vo pozadina i vednas se vrakja
+static void playSong(uint8_t * song) {
+  if (song_pos != NULL)
+    return;
+  song_pos = song;
+  timer_start(TMR_SONG, song_step, 0, 0);
 }
 
 static uint8_t * song = (uint8_t * )
 "G1,G1,G1";
 
-int p(int n) {
-  int i = 0;
-  int s = 1;
-  for (i = 0; i < n; i++)
-    s *= 2;
-  return s;
+/*
+ * LED bar output. Temperature lights LED0..7 and light LED8..15, one
+ * LED per 5 graph units. The mask comes from a table and the bus is
+ * only touched when it differs from what is already shown.
+ */
+#define LED_BAR(n) ((1 << (n)) - 1)
+
+static const uint8_t led_bar[LED_BAR_LEVELS] = {
+  LED_BAR(0), LED_BAR(1), LED_BAR(2), LED_BAR(3), LED_BAR(4),
+  LED_BAR(5), LED_BAR(6), LED_BAR(7), LED_BAR(8)
+};
+
+static uint8_t led_level(int32_t v) {
+  int32_t n = v / 5;
+  if (n < 0)
+    return 0;
+  return n >= LED_BAR_LEVELS ? LED_BAR_LEVELS - 1 : n;
 }
 
-char * svetki(int t, int o) {
+static void led_out(uint16_t on) {
+  if (led_shadow == on) {
+    out_stats.led_skipped++;
+    return;
+  }
+  led_shadow = on;
+  out_stats.led_writes++;
+  pca9532_setLedsAsync(on);
+}
 
-  //vkupno = "0000";
+// LED_NONE se preskoknuva pred shift-ot
+#define X_LED_CASE(ch, name, rd, norm, bits, bias, led) \
+  case ch: \
+    if ((led) != LED_NONE) \
+      led_out(led_bar[led_level(v)] << ((led) & 15)); \
+    break;
 
-  vkupno[0] = '0';
-  vkupno[1] = '0';
-  vkupno[2] = '0';
-  vkupno[3] = 'x';
-  vkupno[4] = '\0';
+// LED lentata za kanalot ch
+void sveti(int ch, int32_t v) {
+  if (ch == CH_TEMPERATURE && v / 5 > 6) {
+    //sviri
+    playSong(song);
+  }
+  switch (ch) {
+    SENSORS(X_LED_CASE)
+  }
+}
 
-  if (t < 4) {
-    vkupno[3] = (char)(p(t) - 1 + 48);
-  } else if (t == 4) {
-    vkupno[3] = 'f';
-  } else if (t > 4 && t < 8) {
-    vkupno[3] = 'f';
-    vkupno[2] = (char)(p(t - 4) - 1 + 48);
-  } else {
-    vkupno[3] = 'f';
-    vkupno[2] = 'f';
+void draw_graph_real_time(sample_window_t * w, char * measurements) {
+  int n = w->count;
+  fb_clearScreen(OLED_COLOR_WHITE);
+  fb_putString(12, 1, measurements, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
+  for (int j = n - 1, k = 96; j > 0; j--, k -= GRAPH_STEP)
+    fb_line(k - GRAPH_STEP, 64 - window_get(w, j - 1), k, 64 - window_get(w, j), OLED_COLOR_BLACK);
+  PROF_BEGIN(PRF_FLUSH);
+  fb_flush();
+  PROF_END(PRF_FLUSH);
+}
+
+// LED lentata ja sledi najnovata vrednost na prikazaniot grafik
+void led_task(void) {
+  if (active_window == NULL || active_window->count == 0)
+    return;
+  int32_t last = window_get(active_window, active_window->count - 1);
+
+  PROF_BEGIN(PRF_LEDS);
+  sveti(sel_ch, last);
+  PROF_END(PRF_LEDS);
+}
+
+static void init_rec_clock(void) {
+  TIM_TIMERCFG_Type TIM_ConfigStruct;
+  TIM_MATCHCFG_Type TIM_MatchConfigStruct;
+
+  TIM_ConfigStruct.PrescaleOption = TIM_PRESCALE_USVAL;
+  TIM_ConfigStruct.PrescaleValue = 1;
+  TIM_Init(LPC_TIM0, TIM_TIMER_MODE, & TIM_ConfigStruct);
+
+  // bez reset, MR0 sekogas e apsolutniot rok
+  TIM_MatchConfigStruct.MatchChannel = 0;
+  TIM_MatchConfigStruct.IntOnMatch = TRUE;
+  TIM_MatchConfigStruct.ResetOnMatch = FALSE;
+  TIM_MatchConfigStruct.StopOnMatch = FALSE;
+  TIM_MatchConfigStruct.ExtMatchOutputType = TIM_EXTMATCH_NOTHING;
+  TIM_MatchConfigStruct.MatchValue = 0;
+  TIM_ConfigMatch(LPC_TIM0, & TIM_MatchConfigStruct);
+
+  NVIC_EnableIRQ(TIMER0_IRQn);
+}
+
+/*
+ * Snapshot for the record due now. The potentiometer comes straight
+ * from the ADC ring, light and acceleration are the latest async I2C
+ * results and the temperature the latest MAX6576 measurement. New
+ * reads are started here, so the next record has values taken after
+ * this deadline; the slowest, the temperature at about 130 ms, is done
+ * well within the shortest period.
+ */
+static void rec_push(void) {
+  uint8_t depth = rec_q_head - rec_q_tail;
+
+  if (depth >= REC_QUEUE_SIZE) {
+    rec_clock.dropped++;
+    return;
   }
+  rec_sample_t * r = & rec_q[rec_q_head & (REC_QUEUE_SIZE - 1)];
+  r->v[CH_TEMPERATURE] = temp_value;
+  r->v[CH_LIGHT] = light_lux;
+  r->v[CH_POTENTIOMETER] = adc_average(ADC_AVERAGE);
+  r->v[CH_ACCELERATION] = acc_z;
+  rec_q_head++;
+  temp_request();
+  light_request();
+  acc_request();
+
+  if (depth + 1 > rec_clock.depth_max)
+    rec_clock.depth_max = depth + 1;
+  rec_clock.samples++;
+  event_post(EV_RECORD_SAMPLE);
+}
 
-  if (o < 4) {
-    vkupno[1] = (char)(p(o) - 1 + 48);
-  } else if (o == 4) {
-    vkupno[1] = 'f';
-  } else if (o > 4 && o < 8) {
-    vkupno[1] = 'f';
-    vkupno[0] = (char)(p(o - 4) - 1 + 48);
-  } else {
-    vkupno[1] = 'f';
-    vkupno[0] = 'f';
+void TIMER0_IRQHandler(void) {
+  uint32_t late = LPC_TIM0->TC - rec_clock.deadline;
+
+  TIM_ClearIntPending(LPC_TIM0, TIM_MR0_INT);
+  if (!rec_clock.running)
+    return;
+
+  // ostanuvame na mrezata od rokovi, preskoknatite se brojat
+  if (late >= rec_clock.period_us) {
+    uint32_t n = late / rec_clock.period_us;
+    rec_clock.missed += n;
+    rec_clock.deadline += n * rec_clock.period_us;
+    late -= n * rec_clock.period_us;
+  }
+  if (late > rec_clock.late_max)
+    rec_clock.late_max = late;
+  rec_clock.late_sum += late;
+
+  rec_push();
+  if (rec_clock.samples + rec_clock.dropped >= rec_clock.count) {
+    rec_clock.running = 0;
+    TIM_Cmd(LPC_TIM0, DISABLE);
+    return;
   }
+  rec_clock.deadline += rec_clock.period_us;
+  TIM_UpdateMatchValue(LPC_TIM0, 0, rec_clock.deadline);
+}
 
-  return vkupno;
+// prviot od count zapisi e vednas, sledniot na period_ms od nego
+static void rec_clock_start(uint32_t period_ms, uint16_t count) {
+  memset( & rec_clock, 0, sizeof(rec_clock));
+  rec_q_tail = rec_q_head;
+  rec_clock.period_us = period_ms * 1000;
+  rec_clock.count = count;
+  rec_clock.running = 1;
+
+  TIM_Cmd(LPC_TIM0, DISABLE);
+  TIM_ResetCounter(LPC_TIM0);
+  rec_push();
+  rec_clock.deadline = rec_clock.period_us;
+  TIM_UpdateMatchValue(LPC_TIM0, 0, rec_clock.deadline);
+  TIM_Cmd(LPC_TIM0, ENABLE);
 }
 
-void sveti_temperatra(int32_t temperatura) {
-  int temp = temperatura / 5;
-  if (temp > 6) {
-    //sviri
-    playSong(song);
-  }
-  char rez[4];
-  svetki(temp, 0);
+static void rec_clock_stop(void) {
+  if (rec_clock.period_us == 0)
+    return;
+  rec_clock.running = 0;
+  TIM_Cmd(LPC_TIM0, DISABLE);
+  LOG(LOG_REC_CLOCK, rec_clock.period_us, rec_clock.late_max,
+    rec_clock.samples ? rec_clock.late_sum / rec_clock.samples : 0,
+    rec_clock.missed, rec_clock.dropped);
+  rec_clock.period_us = 0;
+}
+
+void zapisi(const int32_t * v) {
+  uint8_t b[REC_SIZE];
 
-  long sv = strtol(vkupno, NULL, 16);
-  pca9532_setLeds(sv, 0xffff);
+  //sostavi zapis
+  record_encode(b, v);
+
+  store_put(b);
 }
 
-void sveti_osvetluvanje(int32_t osvetluvanje) {
-  int osv = osvetluvanje / 5;
-  svetki(0, osv);
-  long sv = strtol(vkupno, NULL, 16);
-  pca9532_setLeds(sv, 0xffff);
+// zapisite od rec_q odat vo EEPROM od glavniot ciklus
+static void rec_drain(void) {
+  while (rec_q_tail != rec_q_head && rec_n < REC_COUNT) {
+    tlm_send(TLM_RECORD, rec_n);
+    zapisi(rec_q[rec_q_tail & (REC_QUEUE_SIZE - 1)].v);
+    rec_q_tail++;
+    rec_n++;
+  }
 }
 
-void draw_graph_real_time(int32_t values[13], int n, char * measurements) {
-  int i = 0;
-  oled_clearScreen(OLED_COLOR_WHITE);
-  oled_putString(12, 1, measurements, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-  for (int j = n - 1, k = 96; j > 0; j--, k -= 8)
-    oled_line(k - 8, 64 - values[j - 1], k, 64 - values[j], OLED_COLOR_BLACK);
+static void record_finish(void) {
+  rec_clock_stop();
+  rec_drain();
+  store_commit();
+  LOG(LOG_RECORD_DONE, rec_n, store.page_writes);
+  LOG(LOG_STORE, store.session, store.head, store.record_bytes, store.page_writes);
+}
+
+// na EV_RECORD_SAMPLE, zapisite od TIMER0 vo EEPROM
+static void record_task(void) {
+  rec_drain();
 
-  if (measurement_option == 1) {
-    sveti_temperatra(values[0]);
-    printf("Temperatura: %d\n", values[0]);
-  } else if (measurement_option == 2) {
-    sveti_osvetluvanje(values[0]);
-    printf("Svetlina: %d\n", values[0]);
+  // so frleni zapisi casovnikot zastanuva pred REC_COUNT
+  if (rec_n >= REC_COUNT || (!rec_clock.running && rec_q_tail == rec_q_head)) {
+    record_finish();
+    event_post(EV_RECORD_DONE);
   }
+}
 
+// snimanjeto prekinato so reset prodolzuva so istiot period, vrakja 0 ako nema sto
+static int record_resume(void) {
+  if (!store.resume)
+    return 0;
+  store_resume();
+  rec_n = store.session_recs;
+  if (rec_n >= REC_COUNT) {
+    store_commit(); // zapisite se site tuka, falese samo krajot
+    return 0;
+  }
+  ch7seg = '1' + (store.info & STORE_PERIOD_MASK);
+  seg_setChar(ch7seg);
+  show_period();
+  ui_state = UI_RECORDING;
+  rec_clock_start(rec_periods[ch7seg - '1'], REC_COUNT - rec_n);
+  return 1;
 }
 
-void zapisi(int32_t temperatura, uint32_t osvetluvanje, uint32_t potenciometar, int i) {
-  int dolzina_zapis = 11;
-  int mem = 0;
-  int br = 90;
-  if (i > br) {
-    i = 0;
+static void ui_event(uint8_t ev) {
+  if (ev == EV_SW3_LONG) {
+    if (ui_state == UI_RECORDING)
+      record_finish();
+    if (ui_state == UI_CAPTURE)
+      cap_stop();
+    stop_view();
+    show_modes();
+    ui_state = UI_MODES;
+    return;
   }
+  if (ev == EV_SW4_LONG) {
+    prof_dump();
+    LOG(LOG_IDLE, idle_stats.active_ticks, idle_stats.sleep_ticks, idle_stats.wakeups);
+    return;
+  }
+
+  switch (ui_state) {
+  case UI_MODES:
+    if (ev == EV_SW3) {
+      fb_circle(5, MENU_ROW(mode, MODE_COUNT) + 3, 3, OLED_COLOR_WHITE);
+      mode = (mode + 1) % MODE_COUNT;
+      fb_circle(5, MENU_ROW(mode, MODE_COUNT) + 3, 3, OLED_COLOR_BLACK);
+      seg_setChar('1' + mode);
+      fb_flush();
+    } else if (ev == EV_SW4) {
+      if (mode == MODE_CAPTURE) {
+        cap_start();
+      } else if (mode == MODE_SAVE) { //save
+        show_period();
+        change7Seg();
+        ui_state = UI_CHOOSE_TIME;
+      } else { //real time, read
+        show_sensors();
+        ui_state = UI_SENSORS;
+      }
+    }
+    break;
 
-  char b[dolzina_zapis];
+  case UI_SENSORS:
+    if (ev == EV_SW3) {
+      fb_circle(5, MENU_ROW(sel_ch, CH_COUNT) + 3, 3, OLED_COLOR_WHITE);
+      sel_ch = (sel_ch + 1) % CH_COUNT;
+      fb_circle(5, MENU_ROW(sel_ch, CH_COUNT) + 3, 3, OLED_COLOR_BLACK);
+      fb_flush();
+    } else if (ev == EV_SW4) {
+      start_view();
+    }
+    break;
 
-  //sostavi zapis
-  sprintf(b, "%03d%04d%04d", temperatura, osvetluvanje, potenciometar);
+  case UI_REALTIME:
+    if (ev == EV_SW3) {
+      stop_view();
+      show_modes();
+      ui_state = UI_MODES;
+    } else if (ev == EV_SW4) {
+      // sleden kanal, istorijata e vekje tuka
+      sel_ch = (sel_ch + 1) % CH_COUNT;
+      active_window = & history[sel_ch];
+      draw_graph_real_time(active_window, channel_names[sel_ch]);
+    }
+    break;
+
+  case UI_SAVED:
+    if (ev == EV_SW3) {
+      stop_view();
+      show_modes();
+      ui_state = UI_MODES;
+    } else if (ev == EV_SW4) {
+      // prethodnata sesija, po najstarata pak poslednata
+      saved_back++;
+      show_saved();
+      if (saved_count == 0) {
+        saved_back = 0;
+        show_saved();
+      }
+    }
+    break;
+
+  case UI_CHOOSE_TIME:
+    if (ev == EV_SW3) {
+      ch7seg++;
+      change7Seg();
+      show_period();
+      LOG(LOG_CH7SEG, ch7seg);
+    } else if (ev == EV_SW4) {
+      rec_n = 0;
+      store_begin(ch7seg - '1');
+      ui_state = UI_RECORDING;
+      rec_clock_start(rec_periods[ch7seg - '1'], REC_COUNT);
+    }
+    break;
+
+  case UI_CAPTURE:
+    if (ev == EV_SW3) {
+      cap_stop();
+      show_modes();
+      ui_state = UI_MODES;
+    } else if (ev == EV_SW4) {
+      // snimanjeto na blokovi se vklucuva i isklucuva
+      if (cap_store) {
+        record_finish();
+        cap_store = 0;
+      } else {
+        rec_n = 0;
+        store_begin(STORE_NO_PERIOD);
+        cap_store = 1;
+      }
+    }
+    break;
+
+  case UI_RECORDING:
+    if (ev == EV_RECORD_SAMPLE) {
+      record_task();
+    } else if (ev == EV_RECORD_DONE) {
+      show_modes();
+      ui_state = UI_MODES;
+    }
+    break;
+  }
+}
 
-  //ke zapiseme na pozicija i do i+11
-  int pozicija = i * dolzina_zapis;
-  eeprom_write(b, pozicija, dolzina_zapis);
+/*
+ * Cooperative scheduler: runs every expired software timer and then
+ * hands queued events to the UI. Nothing in here may block.
+ */
+static void sched_run(void) {
+  uint32_t now = msTicks;
+  uint8_t ev;
+
+  for (int i = 0; i < SCHED_TIMERS; i++) {
+    sw_timer_t * t = & timers[i];
+    if (!t->active || (int32_t)(now - t->due) < 0)
+      continue;
+
+    uint32_t late = now - t->due;
+    if (late > t->max_late)
+      t->max_late = late;
+    t->runs++;
+
+    if (t->period == 0) {
+      t->active = 0;
+    } else {
+      t->due += t->period;
+      // ako sme zaostanale povekje od eden period, preskokni
+      if ((int32_t)(now - t->due) >= 0)
+        t->due = now + t->period;
+    }
+    t->fn();
+  }
 
-  i++;
+  while ((ev = event_get()) != EV_NONE)
+    ui_event(ev);
+
+  log_flush();
 }
 
-int main(void)
+/*
+ * Nothing is due until the next tick or interrupt. PRIMASK keeps an
+ * event posted after the check from being slept through; WFI still
+ * wakes on it and the handler runs when cpu_sleep() unmasks.
+ */
+static void sched_idle(void) {
+  __disable_irq();
+  if (ev_head == ev_tail)
+    cpu_sleep();
+  else
+    __enable_irq();
+}
 
-{
+// aktivnoto vreme od poslednata sekunda, vo promili
+static void duty_task(void) {
+  uint32_t active = idle_stats.active_ticks - duty_active;
+  uint32_t sleep = idle_stats.sleep_ticks - duty_sleep;
+
+  duty_active = idle_stats.active_ticks;
+  duty_sleep = idle_stats.sleep_ticks;
+  if (active + sleep > 0)
+    tlm_send(TLM_DUTY, active * 1000 / (active + sleep));
+}
+
+static void init_app(void) {
+  init_dma();
   init_i2c();
   init_ssp();
   init_adc();
 
   eeprom_init();
+  store_init();
   oled_init();
+  fb_init();
   light_init();
-  temp_init( & getTicks);
+  init_temp();
 
   led7seg_init();
+  init_tone();
+  init_capture();
+  init_rec_clock();
+  init_buttons();
+  init_prof();
+#if TELEMETRY
+  init_tlm();
+#endif
 
   if (SysTick_Config(SystemCoreClock / 1000)) {
     while (1); // Capture error
@@ -598,114 +3194,32 @@ int main(void)
 
   light_enable();
   light_setRange(LIGHT_RANGE_4000);
+  light_lux = light_read();
+  acc_init();
 
-  display_working_modes();
-  oled_circle(5, 22, 3, OLED_COLOR_BLACK);
-  led7seg_setChar('1', FALSE);
-  while (1) {
+  // prvoto merenje na temperaturata, za da ne se prikaze 0
+  temp_request();
+  CPU_WAIT_WHILE(temp_busy);
 
-    btn2 = ((GPIO_ReadValue(1) >> 31) & 0x01);
-    Timer0_Wait(200);
-    if (btn2 == 0) {
-      btn2 = 1;
-      switch (mode) {
-      case 1: //real time
-        display_menu();
-        display_working_modes();
-        oled_circle(5, 22, 3, OLED_COLOR_BLACK);
-
-        break;
-      case 2: //save
-        oled_clearScreen(OLED_COLOR_WHITE);
-        oled_putString(1, 1, "Choose time!", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-
-        while (1) {
-          btn2 = ((GPIO_ReadValue(1) >> 31) & 0x01); //enter
-          btn1 = ((GPIO_ReadValue(0) >> 4) & 0x01); //++
-          //printf("while\n", ch7seg++);
-
-          if (btn1 == 0) {
-            Timer0_Wait(200);
-            ch7seg++;
-            change7Seg();
-            printf("ch7seg++: %d\n", ch7seg);
-            printf("n: %d\n 0", 0);
-          }
-          if (btn2 == 0) {
-            Timer0_Wait(200);
-
-            int n = 0;
-            // oled_clearScreen(OLED_COLOR_WHITE);
-            // oled_putString(1,1,  ch7seg, OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-            // oled_putString(1,8,  " minutes", OLED_COLOR_BLACK, OLED_COLOR_WHITE);
-
-            printf("n: %d\n", 0);
-
-            while (n < 90) {
-              printf("n: %d\n", n);
-
-              //zemi merki za temperatura, osvetluvanje i potenciometar
-              int32_t t = 0;
-              int32_t tn = 0;
-              uint32_t lux = 0;
-              uint32_t luxn = 0;
-              uint32_t p = 0;
-              int32_t pn = 0;
-
-              t = temp_read();
-              tn = normalize_temperature(t);
-              lux = light_read();
-              luxn = normalize_light(lux);
-              p = ADC_ChannelGetData(LPC_ADC, ADC_CHANNEL_0);
-              pn = normalize_potentiometer(p);
-
-              //zapisi
-              zapisi(tn, luxn, pn, n);
-              n++;
-              //cekaj
-              Timer0_Wait(ch7seg * 2 / 3);
-            }
-
-            display_working_modes();
-            btn1 = 1;
-            break;
-          }
-        }
-        break;
-      case 0: //read
-        printf("Option 3.");
-
-        display_menu();
-        display_working_modes();
-        oled_circle(5, 52, 3, OLED_COLOR_BLACK);
-        break;
-      }
-    }
-    btn1 = ((GPIO_ReadValue(0) >> 4) & 0x01);
-    Timer0_Wait(200);
-    if (btn1 == 0) {
-      mode++;
-      btn1 = 1;
-      switch (mode) {
-      case 1:
-        oled_circle(5, 52, 3, OLED_COLOR_WHITE);
-        oled_circle(5, 22, 3, OLED_COLOR_BLACK);
-        led7seg_setChar('1', FALSE);
-        break;
-      case 2:
-        oled_circle(5, 22, 3, OLED_COLOR_WHITE);
-        oled_circle(5, 37, 3, OLED_COLOR_BLACK);
-        led7seg_setChar('2', FALSE);
-        break;
-      case 3:
-        mode = 0;
-        oled_circle(5, 37, 3, OLED_COLOR_WHITE);
-        oled_circle(5, 52, 3, OLED_COLOR_BLACK);
-        led7seg_setChar('3', FALSE);
-        break;
-      }
-      Timer0_Wait(2000);
-    }
+  // od ovde I2C2 odi preku redicata
+  NVIC_EnableIRQ(I2C2_IRQn);
+
+  if (!record_resume()) {
+    show_modes();
+    seg_setChar('1');
+  }
+
+  timer_start(TMR_SAMPLE, acquire_task, 0, SAMPLE_PERIOD);
+  timer_start(TMR_DUTY, duty_task, DUTY_PERIOD, DUTY_PERIOD);
+}
+
+int main(void)
+
+{
+  init_app();
 
+  while (1) {
+    sched_run();
+    sched_idle();
   }
 }